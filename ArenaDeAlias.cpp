@@ -0,0 +1,94 @@
+#include "ArenaDeAlias.h"
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+
+size_t ArenaDeAlias::ocupa(size_t largo){
+    return largo + (largo < largo_extendido ? 1 : 3);
+}
+// Complejidad: O(1)
+
+ArenaDeAlias::Alias ArenaDeAlias::guardar(string_view alias){
+    if (alias.empty()) return ninguno;
+    if (alias.size() > largo_maximo) {
+        throw length_error("alias demasiado largo");
+    }
+    const size_t tamanio = ocupa(alias.size());
+    Alias lugar;
+    if (tamanio < libres_por_tamanio.size() && !libres_por_tamanio[tamanio].empty()) {
+        lugar = libres_por_tamanio[tamanio].back(); // O(1), se reusa uno liberado
+        libres_por_tamanio[tamanio].pop_back();
+        cantidad_libres--;
+    } else {
+        if (usados_en_bloque + tamanio > bytes_por_bloque) {
+            if (bloques.size() == bytes_por_bloque) {
+                throw length_error("arena de alias llena");
+            }
+            bloques.emplace_back(new char[bytes_por_bloque]); // O(1) amortizado
+            usados_en_bloque = 0;
+        }
+        lugar = (Alias)((bloques.size() - 1) << 16 | usados_en_bloque);
+        usados_en_bloque += tamanio;
+    }
+    char * p = bloques[lugar >> 16].get() + (lugar & 0xFFFF);
+    if (alias.size() < largo_extendido) {
+        *p++ = (char)alias.size();
+    } else {
+        uint16_t largo = (uint16_t)alias.size();
+        *p++ = (char)largo_extendido;
+        memcpy(p, &largo, sizeof(largo));
+        p += sizeof(largo);
+    }
+    memcpy(p, alias.data(), alias.size());     // O(|alias|)
+    bytes_guardados += tamanio;
+    return lugar;
+}
+// Complejidad: O(|alias|) amortizado
+
+string_view ArenaDeAlias::ver(Alias alias) const{
+    if (alias == ninguno) return string_view();
+    const char * p = bloques[alias >> 16].get() + (alias & 0xFFFF);
+    size_t largo = (unsigned char)*p++;
+    if (largo == largo_extendido) {
+        uint16_t extendido;
+        memcpy(&extendido, p, sizeof(extendido));
+        largo = extendido;
+        p += sizeof(extendido);
+    }
+    return string_view(p, largo);
+}
+// Complejidad: O(1)
+
+void ArenaDeAlias::liberar(Alias alias){
+    if (alias == ninguno) return;
+    const size_t tamanio = ocupa(ver(alias).size());
+    if (tamanio >= libres_por_tamanio.size()) {
+        libres_por_tamanio.resize(tamanio + 1); // O(|alias|), los alias son cortos
+    }
+    libres_por_tamanio[tamanio].push_back(alias); // O(1) amortizado
+    cantidad_libres++;
+    bytes_guardados -= tamanio;
+}
+// Complejidad: O(1) amortizado
+
+void ArenaDeAlias::vaciar(){
+    bloques.clear();                           // O(cantidad de bloques)
+    usados_en_bloque = bytes_por_bloque;
+    libres_por_tamanio.clear();
+    cantidad_libres = 0;
+    bytes_guardados = 0;
+}
+// Complejidad: O(cantidad de bloques)
+
+size_t ArenaDeAlias::bytes_reservados() const{
+    size_t bytes = bloques.capacity() * sizeof(unique_ptr<char[]>) + bloques.size() * bytes_por_bloque;
+    bytes += libres_por_tamanio.capacity() * sizeof(vector<Alias>) + cantidad_libres * sizeof(Alias);
+    return bytes;
+}
+// Complejidad: O(1)
+
+size_t ArenaDeAlias::bytes_en_uso() const{
+    return bytes_guardados;
+}
+// Complejidad: O(1)
@@ -0,0 +1,65 @@
+#ifndef __ARENADEALIAS_H__
+#define __ARENADEALIAS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Arena donde se guarda una sola copia de cada alias. Los bytes se reservan de a bloques
+// grandes que nunca se mueven, así que los string_view que devuelve ver() siguen
+// valiendo hasta que se libere ese alias o se vacíe la arena. Lo liberado se reusa
+// para alias nuevos que ocupen lo mismo.
+//
+// Cada alias se identifica con un Alias de 4 bytes (bloque y posición dentro del bloque)
+// y se guarda con su largo adelante: 1 byte para los alias de menos de 255 caracteres,
+// que son casi todos, y 3 para los más largos. Así un alias corto ocupa |alias| + 1
+// bytes, sin el string ni el string_view de 16 bytes que habría que guardar por usuario.
+
+class ArenaDeAlias {
+  public:
+    using Alias = uint32_t;
+    static constexpr Alias ninguno = UINT32_MAX; // el alias vacío, no ocupa lugar
+    static constexpr size_t largo_maximo = (1 << 16) - 3;
+
+    ArenaDeAlias() = default;
+    ArenaDeAlias(const ArenaDeAlias &) = delete;
+    ArenaDeAlias & operator=(const ArenaDeAlias &) = delete;
+
+    Alias guardar(string_view alias); // O(|alias|) amortizado; lanza length_error si supera largo_maximo
+    string_view ver(Alias alias) const; // O(1)
+    void liberar(Alias alias); // O(1) amortizado; alias tiene que venir de guardar()
+    void vaciar(); // O(cantidad de bloques)
+
+    size_t bytes_reservados() const; // O(1), bloques y lugares libres anotados
+    size_t bytes_en_uso() const; // O(1), largos y caracteres de los alias guardados
+
+  private:
+    static constexpr size_t bytes_por_bloque = 1 << 16;
+    static constexpr unsigned char largo_extendido = 255; // el largo sigue en 2 bytes
+
+    static size_t ocupa(size_t largo);
+
+    vector<unique_ptr<char[]>> bloques;
+    size_t usados_en_bloque = bytes_por_bloque; // bytes ocupados del último bloque
+    vector<vector<Alias>> libres_por_tamanio; // bytes ocupados -> lugares liberados de ese tamaño
+    size_t cantidad_libres = 0; // Σ |libres_por_tamanio[t]|
+    size_t bytes_guardados = 0; // Σ ocupa(|alias|) de los alias guardados y no liberados
+};
+
+// Hash transparente para alias: con equal_to<> como comparación, los unordered_map con
+// claves string o string_view se consultan con cualquiera de los dos sin armar un string
+struct HashDeAlias {
+    using is_transparent = void;
+    size_t operator()(string_view alias) const { return hash<string_view>{}(alias); }
+};
+
+template <class Clave, class Valor>
+using MapaPorAlias = unordered_map<Clave, Valor, HashDeAlias, equal_to<>>;
+
+#endif
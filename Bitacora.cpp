@@ -0,0 +1,186 @@
+#include "Bitacora.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+using namespace std;
+
+static const size_t bytes_encabezado_registro = 2 * sizeof(uint32_t);
+static const size_t bytes_fijos_contenido = sizeof(uint64_t) + sizeof(uint8_t) + 2 * sizeof(int32_t);
+
+static uint32_t crc32(const char * datos, size_t largo) {
+    // CRC-32 (polinomio 0xEDB88320), con la tabla calculada una sola vez
+    static const auto tabla = [] {
+        array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < largo; i++) {
+        crc = tabla[(crc ^ (uint8_t)datos[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+// Complejidad: O(largo)
+
+// Decodifica el registro que empieza en 'pos'. Devuelve cuántos bytes ocupa, o 0 si
+// está incompleto o corrupto
+static size_t decodificar(const string & datos, size_t pos, Bitacora::Registro & registro){
+    if (datos.size() - pos < bytes_encabezado_registro) return 0;
+    uint32_t largo, crc;
+    memcpy(&largo, datos.data() + pos, sizeof(largo));
+    memcpy(&crc, datos.data() + pos + sizeof(largo), sizeof(crc));
+    const char * contenido = datos.data() + pos + bytes_encabezado_registro;
+    if (largo < bytes_fijos_contenido || datos.size() - pos - bytes_encabezado_registro < largo ||
+        crc32(contenido, largo) != crc) {
+        return 0;
+    }
+    uint8_t tipo;
+    int32_t id_A, id_B;
+    memcpy(&registro.secuencia, contenido, sizeof(uint64_t));
+    memcpy(&tipo, contenido + 8, sizeof(tipo));
+    memcpy(&id_A, contenido + 9, sizeof(id_A));
+    memcpy(&id_B, contenido + 13, sizeof(id_B));
+    if (tipo < Bitacora::registro_usuario || tipo > Bitacora::baja_amistad) return 0;
+    registro.tipo = (Bitacora::Tipo)tipo;
+    registro.id_A = id_A;
+    registro.id_B = id_B;
+    registro.alias.assign(contenido + bytes_fijos_contenido, largo - bytes_fijos_contenido);
+    return bytes_encabezado_registro + largo;
+}
+// Complejidad: O(largo del registro)
+
+static string leer_todo(const string & ruta, bool & existe){
+    ifstream archivo(ruta, ios::binary);
+    existe = (bool)archivo;
+    return string(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+}
+// Complejidad: O(tamaño del archivo)
+
+
+Bitacora::Bitacora(const string & ruta, int registros_por_grupo)
+    : fd(-1), registros_por_grupo(max(1, registros_por_grupo)), cantidad_pendientes(0) {
+    // Buscar dónde termina el último registro válido
+    bool existe;
+    string datos = leer_todo(ruta, existe);
+    size_t fin_valido = sizeof(magia);
+    if (existe && !datos.empty()) {
+        if (datos.size() < sizeof(magia) || memcmp(datos.data(), magia, sizeof(magia)) != 0) {
+            throw runtime_error(ruta + ": no es una bitácora de RedSocial");
+        }
+        Registro registro;
+        while (size_t largo = decodificar(datos, fin_valido, registro)) {
+            fin_valido += largo;
+        }
+    }
+
+    fd = open(ruta.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd == -1) {
+        throw runtime_error("no se pudo abrir " + ruta);
+    }
+    bool ok = true;
+    if (!existe || datos.empty()) {
+        ok = write(fd, magia, sizeof(magia)) == (ssize_t)sizeof(magia) && fdatasync(fd) == 0;
+    } else if (fin_valido < datos.size()) {
+        ok = ftruncate(fd, fin_valido) == 0 && fdatasync(fd) == 0; // descarta la cola rota
+    }
+    if (!ok || lseek(fd, 0, SEEK_END) == -1) {
+        close(fd);
+        throw runtime_error("no se pudo preparar " + ruta);
+    }
+}
+// Complejidad: O(tamaño del archivo), para encontrar el último registro válido
+
+Bitacora::~Bitacora() {
+    try {
+        confirmar();
+    } catch (...) {
+        // no se puede informar desde un destructor; lo pendiente se pierde como en una caída
+    }
+    close(fd);
+}
+// Complejidad: la de confirmar()
+
+void Bitacora::agregar(const Registro & registro) {
+    uint32_t largo = bytes_fijos_contenido + registro.alias.size();
+    size_t inicio = pendiente.size();
+    pendiente.resize(inicio + bytes_encabezado_registro + largo);
+    char * destino = pendiente.data() + inicio;
+    char * contenido = destino + bytes_encabezado_registro;
+
+    uint8_t tipo = registro.tipo;
+    int32_t id_A = registro.id_A, id_B = registro.id_B;
+    memcpy(contenido, &registro.secuencia, sizeof(uint64_t));
+    memcpy(contenido + 8, &tipo, sizeof(tipo));
+    memcpy(contenido + 9, &id_A, sizeof(id_A));
+    memcpy(contenido + 13, &id_B, sizeof(id_B));
+    memcpy(contenido + bytes_fijos_contenido, registro.alias.data(), registro.alias.size());
+    uint32_t crc = crc32(contenido, largo);
+    memcpy(destino, &largo, sizeof(largo));
+    memcpy(destino + sizeof(largo), &crc, sizeof(crc));
+
+    if (++cantidad_pendientes >= registros_por_grupo) {
+        confirmar();
+    }
+}
+// Complejidad: O(|alias|) amortizado, más confirmar() una vez por grupo
+
+void Bitacora::confirmar() {
+    if (pendiente.empty()) return;
+    const char * datos = pendiente.data();
+    size_t restante = pendiente.size();
+    while (restante > 0) {                     // write puede escribir de a partes
+        ssize_t escritos = write(fd, datos, restante);
+        if (escritos < 0) {
+            throw runtime_error("no se pudo escribir la bitácora");
+        }
+        datos += escritos;
+        restante -= escritos;
+    }
+    if (fdatasync(fd) != 0) {
+        throw runtime_error("no se pudo sincronizar la bitácora");
+    }
+    pendiente.clear();
+    cantidad_pendientes = 0;
+}
+// Complejidad: O(bytes pendientes) más un fdatasync
+
+void Bitacora::vaciar() {
+    pendiente.clear();
+    cantidad_pendientes = 0;
+    if (ftruncate(fd, sizeof(magia)) != 0 || lseek(fd, 0, SEEK_END) == -1 || fdatasync(fd) != 0) {
+        throw runtime_error("no se pudo vaciar la bitácora");
+    }
+}
+// Complejidad: O(1) más un fdatasync
+
+int Bitacora::pendientes() const {
+    return cantidad_pendientes;
+}
+// Complejidad: O(1)
+
+vector<Bitacora::Registro> Bitacora::leer(const string & ruta) {
+    bool existe;
+    string datos = leer_todo(ruta, existe);
+    vector<Registro> registros;
+    if (!existe || datos.empty()) return registros;
+    if (datos.size() < sizeof(magia) || memcmp(datos.data(), magia, sizeof(magia)) != 0) {
+        throw runtime_error(ruta + ": no es una bitácora de RedSocial");
+    }
+    size_t pos = sizeof(magia);
+    Registro registro;
+    while (size_t largo = decodificar(datos, pos, registro)) {
+        registros.push_back(registro);
+        pos += largo;
+    }
+    return registros;
+}
+// Complejidad: O(tamaño del archivo)
@@ -0,0 +1,63 @@
+#ifndef __BITACORA_H__
+#define __BITACORA_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Bitácora de escritura anticipada de RedSocial: un archivo al que sólo se agregan
+// registros, uno por modificación. Los registros se acumulan en memoria y se
+// confirman de a grupos, con una sola escritura y un solo fdatasync por grupo.
+//
+// El archivo empieza con 'magia' y cada registro es
+//   [uint32 largo][uint32 crc32 del contenido][contenido de 'largo' bytes]
+// con contenido = [uint64 secuencia][uint8 tipo][int32 id_A][int32 id_B][alias].
+// Una caída a mitad de una escritura deja a lo sumo un registro incompleto o con
+// crc inválido al final; la lectura se detiene ahí.
+
+class Bitacora {
+  public:
+    enum Tipo : uint8_t {
+        registro_usuario = 1, // id_A, alias
+        baja_usuario = 2,     // id_A
+        alta_amistad = 3,     // id_A, id_B
+        baja_amistad = 4      // id_A, id_B
+    };
+
+    struct Registro {
+        uint64_t secuencia;
+        Tipo tipo;
+        int id_A;
+        int id_B;
+        string alias;
+    };
+
+    static constexpr char magia[8] = {'R', 'E', 'D', 'B', 'I', 'T', 'A', 'C'};
+
+    // Abre (o crea) el archivo para agregar registros. Si termina con un registro roto,
+    // lo recorta para que lo que se agregue después se pueda leer. Lanza runtime_error
+    // si no se puede abrir o no es una bitácora
+    Bitacora(const string & ruta, int registros_por_grupo);
+    ~Bitacora(); // confirma lo pendiente
+    Bitacora(const Bitacora &) = delete;
+    Bitacora & operator=(const Bitacora &) = delete;
+
+    void agregar(const Registro & registro); // O(|alias|) amortizado, más confirmar() al completar un grupo
+    void confirmar(); // una escritura y un fdatasync para todo lo pendiente
+    void vaciar(); // descarta todos los registros, confirmados o no
+
+    int pendientes() const; // O(1)
+
+    // Todos los registros válidos del archivo, hasta el primero roto. Un archivo que no
+    // existe es una bitácora vacía
+    static vector<Registro> leer(const string & ruta);
+
+  private:
+    int fd;
+    int registros_por_grupo;
+    int cantidad_pendientes;
+    string pendiente; // registros ya codificados, todavía no escritos
+};
+
+#endif
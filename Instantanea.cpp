@@ -0,0 +1,153 @@
+#include "Instantanea.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+static_assert(sizeof(int) == sizeof(int32_t), "los slots se guardan como int32_t");
+
+
+Instantanea::Instantanea(const string & ruta) : datos(MAP_FAILED), tamanio(0) {
+    int fd = open(ruta.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw runtime_error("no se pudo abrir " + ruta);
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(CabeceraInstantanea)) {
+        close(fd);
+        throw runtime_error(ruta + ": no es una instantánea de RedSocial");
+    }
+    tamanio = info.st_size;
+    datos = mmap(nullptr, tamanio, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                                 // el mapeo sigue vivo sin el descriptor
+    if (datos == MAP_FAILED) {
+        throw runtime_error("no se pudo mapear " + ruta);
+    }
+
+    const CabeceraInstantanea & c = cabecera();
+    string error;
+    if (memcmp(c.magia, magia, sizeof(magia)) != 0) {
+        error = "no es una instantánea de RedSocial";
+    } else if (c.orden_bytes != marca_orden_bytes) {
+        error = "fue escrita con otro orden de bytes";
+    } else if (c.version != version_actual) {
+        error = "versión " + to_string(c.version) + " no soportada";
+    } else {
+        CabeceraInstantanea esperada = c;
+        ubicar_secciones(esperada);
+        if (esperada.tamanio_archivo != tamanio || c.tamanio_archivo != tamanio) {
+            error = "archivo truncado";
+        } else if (memcmp(esperada.seccion, c.seccion, sizeof(c.seccion)) != 0) {
+            error = "secciones inválidas";
+        } else if (!inicios_validos(seccion_inicios_alias, c.bytes_alias) ||
+                   !inicios_validos(seccion_inicios_amigos, c.cantidad_amigos) ||
+                   !inicios_validos(seccion_inicios_conocidos, c.cantidad_conocidos)) {
+            error = "índices inválidos";
+        }
+    }
+    if (!error.empty()) {
+        munmap(datos, tamanio);
+        throw runtime_error(ruta + ": " + error);
+    }
+}
+// Complejidad: O(n) por la validación de los índices, más el costo de mapear el archivo;
+// las páginas de alias, amigos y conocidos se leen recién al usarlas
+
+Instantanea::~Instantanea() {
+    munmap(datos, tamanio);
+}
+// Complejidad: O(1)
+
+const CabeceraInstantanea & Instantanea::cabecera() const {
+    return *static_cast<const CabeceraInstantanea *>(datos);
+}
+// Complejidad: O(1)
+
+int Instantanea::cantidad_slots() const {
+    return cabecera().cantidad_slots;
+}
+// Complejidad: O(1)
+
+int Instantanea::id_de_slot(int slot) const {
+    return seccion<int32_t>(seccion_ids)[slot];
+}
+// Complejidad: O(1)
+
+string_view Instantanea::alias_de_slot(int slot) const {
+    const uint64_t * inicios = seccion<uint64_t>(seccion_inicios_alias);
+    return string_view(seccion<char>(seccion_alias) + inicios[slot], inicios[slot + 1] - inicios[slot]);
+}
+// Complejidad: O(1)
+
+span<const int> Instantanea::amigos(int slot) const {
+    const uint64_t * inicios = seccion<uint64_t>(seccion_inicios_amigos);
+    return span<const int>(seccion<int>(seccion_amigos) + inicios[slot], inicios[slot + 1] - inicios[slot]);
+}
+// Complejidad: O(1)
+
+bool Instantanea::ansioso(int slot) const {
+    return seccion<uint8_t>(seccion_banderas)[slot] & slot_ansioso;
+}
+// Complejidad: O(1)
+
+bool Instantanea::tiene_conocidos(int slot) const {
+    return seccion<uint8_t>(seccion_banderas)[slot] & conocidos_guardados;
+}
+// Complejidad: O(1)
+
+span<const ConocidoGuardado> Instantanea::conocidos(int slot) const {
+    const uint64_t * inicios = seccion<uint64_t>(seccion_inicios_conocidos);
+    return span<const ConocidoGuardado>(seccion<ConocidoGuardado>(seccion_conocidos) + inicios[slot],
+                                        inicios[slot + 1] - inicios[slot]);
+}
+// Complejidad: O(1)
+
+span<const int> Instantanea::orden_por_grado() const {
+    return span<const int>(seccion<int>(seccion_orden_por_grado), cabecera().cantidad_ocupados);
+}
+// Complejidad: O(1)
+
+void Instantanea::ubicar_secciones(CabeceraInstantanea & cabecera) {
+    uint64_t posicion = (sizeof(CabeceraInstantanea) + 7) / 8 * 8;
+    for (int s = 0; s < cantidad_secciones; s++) {
+        cabecera.seccion[s] = posicion;
+        posicion += (bytes_de_seccion(cabecera, (SeccionInstantanea)s) + 7) / 8 * 8; // relleno hasta 8
+    }
+    cabecera.tamanio_archivo = posicion;
+}
+// Complejidad: O(1)
+
+uint64_t Instantanea::bytes_de_seccion(const CabeceraInstantanea & c, SeccionInstantanea s) {
+    switch (s) {
+        case seccion_ids: return c.cantidad_slots * sizeof(int32_t);
+        case seccion_inicios_alias:
+        case seccion_inicios_amigos:
+        case seccion_inicios_conocidos: return (c.cantidad_slots + 1) * sizeof(uint64_t);
+        case seccion_alias: return c.bytes_alias;
+        case seccion_amigos: return c.cantidad_amigos * sizeof(int32_t);
+        case seccion_conocidos: return c.cantidad_conocidos * sizeof(ConocidoGuardado);
+        case seccion_banderas: return c.cantidad_slots * sizeof(uint8_t);
+        case seccion_orden_por_grado: return c.cantidad_ocupados * sizeof(int32_t);
+        default: return 0;
+    }
+}
+// Complejidad: O(1)
+
+bool Instantanea::inicios_validos(SeccionInstantanea s, uint64_t total) const {
+    const uint64_t * inicios = seccion<uint64_t>(s);
+    if (inicios[0] != 0 || inicios[cantidad_slots()] != total) return false;
+    for (int slot = 0; slot < cantidad_slots(); slot++) { // O(n)
+        if (inicios[slot] > inicios[slot + 1]) return false;
+    }
+    return true;
+}
+// Complejidad: O(n)
+
+template <class T>
+const T * Instantanea::seccion(SeccionInstantanea s) const {
+    return reinterpret_cast<const T *>(static_cast<const char *>(datos) + cabecera().seccion[s]);
+}
+// Complejidad: O(1)
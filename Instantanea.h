@@ -0,0 +1,103 @@
+#ifndef __INSTANTANEA_H__
+#define __INSTANTANEA_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+using namespace std;
+
+// Formato binario de las instantáneas de RedSocial. El archivo empieza con una
+// CabeceraInstantanea y sigue con las secciones, cada una alineada a 8 bytes, en
+// las posiciones que indica cabecera.seccion. Los enteros se guardan en el orden
+// de bytes de la máquina que escribió el archivo.
+//
+// Cada slot (ocupado o libre) tiene:
+//   - ids[s]                    id externo, -1 si el slot está libre
+//   - alias[inicios_alias[s] .. inicios_alias[s+1])
+//   - amigos[inicios_amigos[s] .. inicios_amigos[s+1]), ordenados (CSR)
+//   - conocidos[inicios_conocidos[s] .. inicios_conocidos[s+1]), pares (slot, en común),
+//     sólo si el bit 'conocidos_guardados' está prendido en banderas[s]
+// Además, orden_por_grado tiene los slots ocupados en el orden del ranking por cantidad
+// de amigos: de mayor a menor, y a igual cantidad por id.
+
+enum SeccionInstantanea {
+    seccion_ids,
+    seccion_inicios_alias,
+    seccion_alias,
+    seccion_inicios_amigos,
+    seccion_amigos,
+    seccion_inicios_conocidos,
+    seccion_conocidos,
+    seccion_banderas,
+    seccion_orden_por_grado,
+    cantidad_secciones
+};
+
+enum BanderaSlot : uint8_t {
+    slot_ansioso = 1,
+    conocidos_guardados = 2
+};
+
+struct CabeceraInstantanea {
+    char magia[8];
+    uint32_t version;
+    uint32_t orden_bytes;          // marca_orden_bytes, para rechazar archivos de otra arquitectura
+    uint64_t tamanio_archivo;
+    uint64_t cantidad_slots;
+    uint64_t cantidad_ocupados;
+    uint64_t cantidad_amigos;      // Σ |amigos[s]|
+    uint64_t cantidad_conocidos;   // Σ |conocidos[s]| de los slots guardados
+    uint64_t bytes_alias;
+    int64_t amistades_count;
+    int64_t grado_maximo;
+    int64_t slot_mas_popular;
+    int32_t modo_conocidos;
+    int32_t reservado;
+    uint64_t secuencia_bitacora;   // última modificación incluida, ver Bitacora.h
+    uint64_t seccion[cantidad_secciones];
+};
+
+struct ConocidoGuardado {
+    int32_t slot;
+    int32_t en_comun;
+};
+
+class Instantanea {
+  public:
+    static constexpr char magia[8] = {'R', 'E', 'D', 'S', 'O', 'C', 'I', 'A'};
+    static constexpr uint32_t version_actual = 2;
+    static constexpr uint32_t marca_orden_bytes = 0x01020304;
+
+    // Mapea el archivo en memoria, de sólo lectura. Lanza runtime_error si no se puede
+    // abrir o si no es una instantánea válida de esta versión
+    explicit Instantanea(const string & ruta);
+    ~Instantanea();
+    Instantanea(const Instantanea &) = delete;
+    Instantanea & operator=(const Instantanea &) = delete;
+
+    const CabeceraInstantanea & cabecera() const; // O(1)
+    int cantidad_slots() const; // O(1)
+    int id_de_slot(int slot) const; // O(1)
+    string_view alias_de_slot(int slot) const; // O(1)
+    span<const int> amigos(int slot) const; // O(1)
+    bool ansioso(int slot) const; // O(1)
+    bool tiene_conocidos(int slot) const; // O(1)
+    span<const ConocidoGuardado> conocidos(int slot) const; // O(1)
+    span<const int> orden_por_grado() const; // O(1)
+
+    // Completa cabecera.seccion y cabecera.tamanio_archivo a partir de las cantidades
+    // de la cabecera; lo usan tanto quien escribe como quien valida
+    static void ubicar_secciones(CabeceraInstantanea & cabecera); // O(1)
+    static uint64_t bytes_de_seccion(const CabeceraInstantanea & cabecera, SeccionInstantanea s); // O(1)
+
+  private:
+    template <class T>
+    const T * seccion(SeccionInstantanea s) const;
+    bool inicios_validos(SeccionInstantanea s, uint64_t total) const;
+
+    void * datos;
+    size_t tamanio;
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "Instrumentacion.h"
+#include <sstream>
+using namespace std;
+
+
+void Histograma::registrar(uint64_t valor) {
+    cuentas[cubeta_de(valor)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    suma_valores.fetch_add(valor, memory_order_relaxed);
+    uint64_t anterior = maximo_valor.load(memory_order_relaxed);
+    while (anterior < valor && !maximo_valor.compare_exchange_weak(anterior, valor, memory_order_relaxed)) {
+    }
+}
+// Complejidad: O(1)
+
+uint64_t Histograma::cantidad() const {
+    return total.load(memory_order_relaxed);
+}
+// Complejidad: O(1)
+
+uint64_t Histograma::suma() const {
+    return suma_valores.load(memory_order_relaxed);
+}
+// Complejidad: O(1)
+
+uint64_t Histograma::maximo() const {
+    return maximo_valor.load(memory_order_relaxed);
+}
+// Complejidad: O(1)
+
+uint64_t Histograma::percentil(double p) const {
+    uint64_t n = cantidad();
+    if (n == 0) return 0;
+    // El valor en la posición ceil(p% de n), contando desde 1
+    uint64_t objetivo = max<uint64_t>(1, (uint64_t)(p / 100.0 * n + 0.999999));
+    uint64_t acumulado = 0;
+    for (int c = 0; c < cubetas; c++) {        // O(cubetas)
+        acumulado += cuentas[c].load(memory_order_relaxed);
+        if (acumulado >= objetivo) {
+            return min(mayor_valor_de(c), maximo());
+        }
+    }
+    return maximo();
+}
+// Complejidad: O(cubetas)
+
+void Histograma::reiniciar() {
+    for (auto& cuenta : cuentas) cuenta.store(0, memory_order_relaxed); // O(cubetas)
+    total.store(0, memory_order_relaxed);
+    suma_valores.store(0, memory_order_relaxed);
+    maximo_valor.store(0, memory_order_relaxed);
+}
+// Complejidad: O(cubetas)
+
+int Histograma::cubeta_de(uint64_t valor) {
+    if (valor < (uint64_t)subcubetas) return valor; // exactas
+    int exponente = 63 - __builtin_clzll(valor); // posición del bit más alto, >= precision
+    int corrimiento = exponente - precision;
+    int sub = (valor >> corrimiento) & (subcubetas - 1); // los 'precision' bits que le siguen
+    return (corrimiento + 1) * subcubetas + sub;
+}
+// Complejidad: O(1)
+
+uint64_t Histograma::mayor_valor_de(int cubeta) {
+    if (cubeta < subcubetas) return cubeta;
+    int corrimiento = cubeta / subcubetas - 1;
+    uint64_t base = (uint64_t)(subcubetas + cubeta % subcubetas) << corrimiento;
+    return base + ((uint64_t)1 << corrimiento) - 1;
+}
+// Complejidad: O(1)
+
+
+void Instrumentacion::medir(Operacion operacion, uint64_t nanosegundos) {
+    histogramas[(int)operacion].registrar(nanosegundos);
+}
+// Complejidad: O(1)
+
+void Instrumentacion::contar(Contador contador, uint64_t cantidad) {
+    contadores[(int)contador].fetch_add(cantidad, memory_order_relaxed);
+}
+// Complejidad: O(1)
+
+const Histograma & Instrumentacion::histograma(Operacion operacion) const {
+    return histogramas[(int)operacion];
+}
+// Complejidad: O(1)
+
+uint64_t Instrumentacion::contador(Contador contador) const {
+    return contadores[(int)contador].load(memory_order_relaxed);
+}
+// Complejidad: O(1)
+
+void Instrumentacion::reiniciar() {
+    for (auto& histograma : histogramas) histograma.reiniciar();
+    for (auto& contador : contadores) contador.store(0, memory_order_relaxed);
+}
+// Complejidad: O(operaciones * cubetas)
+
+string Instrumentacion::reporte(FormatoReporte formato, const Instrumentacion * medidas,
+                                const vector<pair<string, long long>> & tamanios) {
+    ostringstream salida;
+    const bool json = formato == FormatoReporte::json;
+    // Cada sección es una lista de filas (nombre, valores); en texto va una fila por línea
+    // y en JSON un objeto por sección
+    auto seccion = [&](const char * titulo, const vector<string> & columnas,
+                       const vector<pair<string, vector<uint64_t>>> & filas, bool primera) {
+        if (json) {
+            salida << (primera ? "{" : ", ") << "\"" << titulo << "\": {";
+        } else {
+            salida << (primera ? "" : "\n") << titulo;
+            for (const string & columna : columnas) salida << " " << columna;
+            salida << "\n";
+        }
+        for (size_t f = 0; f < filas.size(); f++) {
+            const auto& [nombre_fila, valores] = filas[f];
+            if (!json) {
+                salida << nombre_fila;
+                for (uint64_t valor : valores) salida << " " << valor;
+                salida << "\n";
+                continue;
+            }
+            salida << (f ? ", " : "") << "\"" << nombre_fila << "\": ";
+            if (columnas.size() == 1) {
+                salida << valores[0];
+                continue;
+            }
+            salida << "{";
+            for (size_t c = 0; c < columnas.size(); c++) {
+                salida << (c ? ", " : "") << "\"" << columnas[c] << "\": " << valores[c];
+            }
+            salida << "}";
+        }
+        if (json) salida << "}";
+    };
+
+    if (medidas) {
+        vector<pair<string, vector<uint64_t>>> operaciones, contadores;
+        for (int o = 0; o < (int)Operacion::cantidad; o++) { // O(operaciones * cubetas)
+            const Histograma & h = medidas->histogramas[o];
+            if (h.cantidad() == 0) continue;
+            operaciones.push_back({nombre((Operacion)o), {h.cantidad(), h.suma(), h.percentil(50), h.percentil(90),
+                                                          h.percentil(99), h.percentil(99.9), h.maximo()}});
+        }
+        for (int c = 0; c < (int)Contador::cantidad; c++) {
+            contadores.push_back({nombre((Contador)c), {medidas->contador((Contador)c)}});
+        }
+        seccion("operaciones", {"llamadas", "total_ns", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns"},
+                operaciones, true);
+        seccion("contadores", {"valor"}, contadores, false);
+    }
+    vector<pair<string, vector<uint64_t>>> filas;
+    for (const auto& [nombre_tamanio, valor] : tamanios) {
+        filas.push_back({nombre_tamanio, {(uint64_t)valor}});
+    }
+    seccion("tamanios", {"valor"}, filas, !medidas);
+    if (json) salida << "}";
+    return salida.str();
+}
+// Complejidad: O(operaciones * cubetas + contadores + |tamanios|)
+
+const char * Instrumentacion::nombre(Operacion operacion) {
+    static const char * const nombres[] = {
+        "registrar_usuario", "eliminar_usuario", "amigar_usuarios", "desamigar_usuarios",
+        "obtener_amigos", "obtener_conocidos", "conocidos_del_usuario_mas_popular",
+        "cargar_en_bloque", "aplicar_cambios_de_amistad", "reconstruir_conocidos_de", "reconstruir_todo",
+        "recalcular_mas_popular", "publicar", "guardar_instantanea", "abrir_instantanea", "recuperar",
+        "distancia", "vecindario", "contar_triangulos", "contar_componentes"};
+    static_assert(sizeof(nombres) / sizeof(nombres[0]) == (int)Operacion::cantidad);
+    return nombres[(int)operacion];
+}
+// Complejidad: O(1)
+
+const char * Instrumentacion::nombre(Contador contador) {
+    static const char * const nombres[] = {
+        "conocidos_reconstruidos", "conocidos_desactualizados", "conocidos_ajustados",
+        "vistas_materializadas", "usuarios_publicados"};
+    static_assert(sizeof(nombres) / sizeof(nombres[0]) == (int)Contador::cantidad);
+    return nombres[(int)contador];
+}
+// Complejidad: O(1)
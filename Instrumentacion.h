@@ -0,0 +1,112 @@
+#ifndef __INSTRUMENTACION_H__
+#define __INSTRUMENTACION_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Instrumentación opcional de RedSocial: cantidad de llamadas e histograma de latencias
+// por operación, y contadores de trabajo interno (conocidos reconstruidos, ajustados,
+// vistas armadas...). Sólo existe si se compila con REDSOCIAL_INSTRUMENTACION (opción de
+// CMake del mismo nombre); si no, las macros de abajo no generan código y RedSocial no
+// guarda nada.
+
+enum class Operacion {
+    registrar_usuario, eliminar_usuario, amigar_usuarios, desamigar_usuarios,
+    obtener_amigos, obtener_conocidos, conocidos_del_usuario_mas_popular,
+    cargar_en_bloque, aplicar_cambios_de_amistad, reconstruir_conocidos_de, reconstruir_todo,
+    recalcular_mas_popular, publicar, guardar_instantanea, abrir_instantanea, recuperar,
+    distancia, vecindario, contar_triangulos, contar_componentes,
+    cantidad
+};
+
+enum class Contador {
+    conocidos_reconstruidos, // slots cuyos conocidos se calcularon desde cero
+    conocidos_desactualizados, // slots perezosos que perdieron sus conocidos
+    conocidos_ajustados, // cambios puntuales a un par de conocidos
+    vistas_materializadas, // conjuntos de alias armados para la API
+    usuarios_publicados, // usuarios copiados a una versión nueva
+    cantidad
+};
+
+enum class FormatoReporte { texto, json };
+
+// Histograma de valores enteros al estilo HDR: cubetas exactas hasta 2^precision y, de
+// ahí en adelante, 2^precision cubetas por cada potencia de 2, así el error relativo de
+// cualquier percentil queda por debajo de 2^-precision. Se puede registrar desde varios
+// hilos a la vez
+class Histograma {
+  public:
+    void registrar(uint64_t valor); // O(1)
+    uint64_t cantidad() const; // O(1)
+    uint64_t suma() const; // O(1)
+    uint64_t maximo() const; // O(1)
+    uint64_t percentil(double p) const; // O(cubetas), p entre 0 y 100
+    void reiniciar(); // O(cubetas)
+
+  private:
+    static constexpr int precision = 5;
+    static constexpr int subcubetas = 1 << precision;
+    static constexpr int cubetas = (64 - precision + 1) * subcubetas;
+
+    static int cubeta_de(uint64_t valor);
+    static uint64_t mayor_valor_de(int cubeta);
+
+    array<atomic<uint64_t>, cubetas> cuentas{};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> suma_valores{0};
+    atomic<uint64_t> maximo_valor{0};
+};
+
+class Instrumentacion {
+  public:
+    void medir(Operacion operacion, uint64_t nanosegundos); // O(1)
+    void contar(Contador contador, uint64_t cantidad = 1); // O(1)
+    const Histograma & histograma(Operacion operacion) const; // O(1)
+    uint64_t contador(Contador contador) const; // O(1)
+    void reiniciar(); // O(operaciones * cubetas)
+
+    // Reporte con las operaciones llamadas alguna vez y los contadores de 'medidas', si no
+    // es nullptr, y los tamaños que se pasen, en texto o JSON
+    static string reporte(FormatoReporte formato, const Instrumentacion * medidas,
+                          const vector<pair<string, long long>> & tamanios);
+
+    static const char * nombre(Operacion operacion);
+    static const char * nombre(Contador contador);
+
+    // Mide desde que se construye hasta que se destruye
+    class Cronometro {
+      public:
+        Cronometro(Instrumentacion & destino, Operacion operacion)
+            : destino(destino), operacion(operacion), inicio(chrono::steady_clock::now()) {}
+        ~Cronometro() {
+            destino.medir(operacion, chrono::duration_cast<chrono::nanoseconds>(
+                                         chrono::steady_clock::now() - inicio).count());
+        }
+
+      private:
+        Instrumentacion & destino;
+        Operacion operacion;
+        chrono::steady_clock::time_point inicio;
+    };
+
+  private:
+    array<Histograma, (int)Operacion::cantidad> histogramas;
+    array<atomic<uint64_t>, (int)Contador::cantidad> contadores{};
+};
+
+// Se usan dentro de RedSocial, donde 'medidas' es su Instrumentacion
+#ifdef REDSOCIAL_INSTRUMENTACION
+#define INSTRUMENTAR(operacion) Instrumentacion::Cronometro cronometro_de_operacion(medidas, Operacion::operacion)
+#define CONTAR(contador, cantidad) medidas.contar(Contador::contador, cantidad)
+#else
+#define INSTRUMENTAR(operacion) ((void)0)
+#define CONTAR(contador, cantidad) ((void)0)
+#endif
+
+#endif
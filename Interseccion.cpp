@@ -0,0 +1,170 @@
+#include "Interseccion.h"
+#include <algorithm>
+#include <cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INTERSECCION_X86 1
+#endif
+using namespace std;
+
+// Todos los núcleos reciben las dos listas y, si salida no es nullptr, escriben ahí los
+// elementos comunes en orden; devuelven cuántos hay
+using Nucleo = int (*)(const int *, size_t, const int *, size_t, int *);
+
+// A partir de esta relación entre los largos conviene galopar
+static const size_t relacion_para_galopar = 32;
+
+
+static int interseccion_escalar(const int * v, size_t nv, const int * w, size_t nw, int * salida){
+    size_t i = 0, j = 0;
+    int cantidad = 0;
+    while (i < nv && j < nw) {                 // O(|v| + |w|), recorrido en paralelo
+        if (v[i] < w[j]) i++;
+        else if (w[j] < v[i]) j++;
+        else {
+            if (salida) salida[cantidad] = v[i];
+            cantidad++;
+            i++;
+            j++;
+        }
+    }
+    return cantidad;
+}
+// Complejidad: O(|v| + |w|)
+
+static int interseccion_galopando(const int * chica, size_t nc, const int * grande, size_t ng, int * salida){
+    size_t j = 0;
+    int cantidad = 0;
+    for (size_t i = 0; i < nc && j < ng; i++) { // O(|chica|) iteraciones
+        // Saltos de 1, 2, 4, ... desde la última posición, y búsqueda binaria en el último tramo
+        size_t desde = j, salto = 1;
+        while (desde + salto < ng && grande[desde + salto] < chica[i]) {
+            desde += salto;
+            salto *= 2;
+        }
+        j = lower_bound(grande + desde, grande + min(ng, desde + salto + 1), chica[i]) - grande;
+        if (j < ng && grande[j] == chica[i]) {
+            if (salida) salida[cantidad] = chica[i];
+            cantidad++;
+            j++;
+        }
+    }
+    return cantidad;
+}
+// Complejidad: O(|chica| log(|grande| / |chica|))
+
+#ifdef INTERSECCION_X86
+// Escribe los elementos de bloque cuyos bits están prendidos en mascara
+static int emitir(const int * bloque, unsigned mascara, int * salida){
+    int cantidad = __builtin_popcount(mascara);
+    if (salida) {
+        for (; mascara; mascara &= mascara - 1) {
+            *salida++ = bloque[__builtin_ctz(mascara)];
+        }
+    }
+    return cantidad;
+}
+// Complejidad: O(1), a lo sumo 8 elementos
+
+// Compara bloques de 4 contra 4 con las 4 rotaciones del bloque de w; avanza el bloque
+// con el máximo menor (o los dos, si empatan)
+__attribute__((target("sse4.2")))
+static int interseccion_sse(const int * v, size_t nv, const int * w, size_t nw, int * salida){
+    size_t i = 0, j = 0;
+    int cantidad = 0;
+    while (i + 4 <= nv && j + 4 <= nw) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + j));
+        __m128i iguales = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(a, b), _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)))));
+        unsigned mascara = _mm_movemask_ps(_mm_castsi128_ps(iguales));
+        cantidad += emitir(v + i, mascara, salida ? salida + cantidad : nullptr);
+        int ultimo_v = v[i + 3], ultimo_w = w[j + 3];
+        if (ultimo_v <= ultimo_w) i += 4;
+        if (ultimo_w <= ultimo_v) j += 4;
+    }
+    return cantidad + interseccion_escalar(v + i, nv - i, w + j, nw - j, salida ? salida + cantidad : nullptr);
+}
+// Complejidad: O(|v| + |w|), de a 4 elementos
+
+// Igual que interseccion_sse, con bloques de 8 y las 8 rotaciones
+__attribute__((target("avx2")))
+static int interseccion_avx2(const int * v, size_t nv, const int * w, size_t nw, int * salida){
+    const __m256i rotar = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    size_t i = 0, j = 0;
+    int cantidad = 0;
+    while (i + 8 <= nv && j + 8 <= nw) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + j));
+        __m256i iguales = _mm256_cmpeq_epi32(a, b);
+        for (int r = 1; r < 8; r++) {
+            b = _mm256_permutevar8x32_epi32(b, rotar);
+            iguales = _mm256_or_si256(iguales, _mm256_cmpeq_epi32(a, b));
+        }
+        unsigned mascara = _mm256_movemask_ps(_mm256_castsi256_ps(iguales));
+        cantidad += emitir(v + i, mascara, salida ? salida + cantidad : nullptr);
+        int ultimo_v = v[i + 7], ultimo_w = w[j + 7];
+        if (ultimo_v <= ultimo_w) i += 8;
+        if (ultimo_w <= ultimo_v) j += 8;
+    }
+    return cantidad + interseccion_sse(v + i, nv - i, w + j, nw - j, salida ? salida + cantidad : nullptr);
+}
+// Complejidad: O(|v| + |w|), de a 8 elementos
+#endif
+
+static Nucleo elegir_nucleo(const char ** nombre){
+#ifdef INTERSECCION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        *nombre = "avx2";
+        return interseccion_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        *nombre = "sse4.2";
+        return interseccion_sse;
+    }
+#endif
+    *nombre = "escalar";
+    return interseccion_escalar;
+}
+// Complejidad: O(1)
+
+static const char * nombre_del_nucleo;
+
+// Se elige en el primer uso, así también sirve desde inicializaciones estáticas de otros archivos
+static Nucleo nucleo(){
+    static const Nucleo elegido = elegir_nucleo(&nombre_del_nucleo);
+    return elegido;
+}
+// Complejidad: O(1)
+
+// Galopa con la lista corta sobre la larga si la diferencia lo justifica; si no, usa el núcleo
+static int interseccion(span<const int> v, span<const int> w, int * salida){
+    if (v.size() > w.size()) swap(v, w);
+    if (v.empty()) return 0;
+    if (w.size() / v.size() >= relacion_para_galopar) {
+        return interseccion_galopando(v.data(), v.size(), w.data(), w.size(), salida);
+    }
+    return nucleo()(v.data(), v.size(), w.data(), w.size(), salida);
+}
+// Complejidad: O(min(|v| + |w|, |v| log(|w| / |v|))) con |v| ≤ |w|
+
+int contar_interseccion(span<const int> v, span<const int> w){
+    return interseccion(v, w, nullptr);
+}
+// Complejidad: la de interseccion
+
+void intersectar(span<const int> v, span<const int> w, vector<int> & salida){
+    size_t inicio = salida.size();
+    salida.resize(inicio + min(v.size(), w.size())); // a lo sumo la lista más corta
+    salida.resize(inicio + interseccion(v, w, salida.data() + inicio));
+}
+// Complejidad: la de interseccion
+
+const char * nucleo_de_interseccion(){
+    nucleo();
+    return nombre_del_nucleo;
+}
+// Complejidad: O(1)
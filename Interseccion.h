@@ -0,0 +1,20 @@
+#ifndef __INTERSECCION_H__
+#define __INTERSECCION_H__
+
+#include <span>
+#include <vector>
+using namespace std;
+
+// Intersección de listas de enteros ordenadas y sin repetidos, como las listas de amigos
+// de RedSocial. Si una lista es mucho más corta que la otra se busca cada elemento de la
+// corta en la larga, galopando; si no, se recorren las dos en paralelo con el núcleo
+// vectorizado que soporte el procesador (AVX2 o SSE4.2), elegido una sola vez al
+// arrancar, o con el recorrido escalar si no hay ninguno.
+
+int contar_interseccion(span<const int> v, span<const int> w); // O(|v| + |w|) u O(min log max)
+void intersectar(span<const int> v, span<const int> w, vector<int> & salida); // idem, agrega en orden
+
+// Nombre del núcleo elegido en esta máquina: "avx2", "sse4.2" o "escalar"
+const char * nucleo_de_interseccion(); // O(1)
+
+#endif
@@ -0,0 +1,138 @@
+#include "MapaDeBits.h"
+#include <algorithm>
+using namespace std;
+
+
+bool MapaDeBits::contiene(int x) const {
+    size_t g = x >> bits_bajos;
+    if (g >= grupos.size()) return false;
+    const Grupo & grupo = grupos[g];
+    uint16_t bajo = x & (valores_por_grupo - 1);
+    if (!grupo.bits.empty()) {
+        return grupo.bits[bajo >> 6] >> (bajo & 63) & 1; // O(1)
+    }
+    return binary_search(grupo.arreglo.begin(), grupo.arreglo.end(), bajo); // O(log maximo_en_arreglo)
+}
+// Complejidad: O(1), acotado por una búsqueda binaria en maximo_en_arreglo elementos
+
+bool MapaDeBits::insertar(int x) {
+    size_t g = x >> bits_bajos;
+    if (g >= grupos.size()) grupos.resize(g + 1); // O(g), una vez por grupo nuevo
+    Grupo & grupo = grupos[g];
+    uint16_t bajo = x & (valores_por_grupo - 1);
+    if (!grupo.bits.empty()) {
+        uint64_t & palabra = grupo.bits[bajo >> 6];
+        uint64_t bit = uint64_t(1) << (bajo & 63);
+        if (palabra & bit) return false;
+        palabra |= bit;                        // O(1)
+    } else {
+        auto it = lower_bound(grupo.arreglo.begin(), grupo.arreglo.end(), bajo);
+        if (it != grupo.arreglo.end() && *it == bajo) return false;
+        grupo.arreglo.insert(it, bajo);        // O(maximo_en_arreglo), corrimiento
+        if ((int)grupo.arreglo.size() > maximo_en_arreglo) {
+            pasar_a_bits(grupo);               // O(valores_por_grupo / 64 + maximo_en_arreglo)
+        }
+    }
+    grupo.cantidad++;
+    total++;
+    return true;
+}
+// Complejidad: O(maximo_en_arreglo) en el peor caso
+
+bool MapaDeBits::borrar(int x) {
+    size_t g = x >> bits_bajos;
+    if (g >= grupos.size()) return false;
+    Grupo & grupo = grupos[g];
+    uint16_t bajo = x & (valores_por_grupo - 1);
+    if (!grupo.bits.empty()) {
+        uint64_t & palabra = grupo.bits[bajo >> 6];
+        uint64_t bit = uint64_t(1) << (bajo & 63);
+        if (!(palabra & bit)) return false;
+        palabra &= ~bit;                       // O(1)
+        grupo.cantidad--;
+        // Con histéresis, para no ir y volver en el borde
+        if (grupo.cantidad <= maximo_en_arreglo / 2) {
+            pasar_a_arreglo(grupo);            // O(valores_por_grupo / 64)
+        }
+    } else {
+        auto it = lower_bound(grupo.arreglo.begin(), grupo.arreglo.end(), bajo);
+        if (it == grupo.arreglo.end() || *it != bajo) return false;
+        grupo.arreglo.erase(it);               // O(maximo_en_arreglo), corrimiento
+        grupo.cantidad--;
+    }
+    total--;
+    return true;
+}
+// Complejidad: O(maximo_en_arreglo) en el peor caso
+
+int MapaDeBits::cantidad() const {
+    return total;
+}
+// Complejidad: O(1)
+
+int MapaDeBits::contar_interseccion(const MapaDeBits & otro) const {
+    int en_comun = 0;
+    size_t cantidad_grupos = min(grupos.size(), otro.grupos.size());
+    for (size_t g = 0; g < cantidad_grupos; g++) { // O(g) iteraciones
+        const Grupo * a = &grupos[g];
+        const Grupo * b = &otro.grupos[g];
+        if (a->cantidad == 0 || b->cantidad == 0) continue;
+        if (!a->bits.empty() && !b->bits.empty()) {
+            for (int w = 0; w < palabras_por_grupo; w++) { // O(valores_por_grupo / 64)
+                en_comun += __builtin_popcountll(a->bits[w] & b->bits[w]);
+            }
+            continue;
+        }
+        if (a->bits.empty() && !b->bits.empty()) swap(a, b);
+        if (!a->bits.empty()) {
+            // b es arreglo: se busca cada uno de sus elementos en los bits de a
+            for (uint16_t bajo : b->arreglo) { // O(|b|)
+                en_comun += a->bits[bajo >> 6] >> (bajo & 63) & 1;
+            }
+            continue;
+        }
+        size_t i = 0, j = 0;                   // dos arreglos: recorrido en paralelo
+        while (i < a->arreglo.size() && j < b->arreglo.size()) { // O(|a| + |b|)
+            if (a->arreglo[i] < b->arreglo[j]) i++;
+            else if (b->arreglo[j] < a->arreglo[i]) j++;
+            else {
+                en_comun++;
+                i++;
+                j++;
+            }
+        }
+    }
+    return en_comun;
+}
+// Complejidad: O(Σ por grupo: valores_por_grupo / 64 entre dos mapas de bits, el arreglo contra
+// un mapa de bits, o la suma de los dos arreglos)
+
+size_t MapaDeBits::bytes() const {
+    size_t total_bytes = grupos.capacity() * sizeof(Grupo);
+    for (const Grupo & grupo : grupos) {       // O(g)
+        total_bytes += grupo.arreglo.capacity() * sizeof(uint16_t) + grupo.bits.capacity() * sizeof(uint64_t);
+    }
+    return total_bytes;
+}
+// Complejidad: O(g)
+
+void MapaDeBits::pasar_a_bits(Grupo & grupo) {
+    grupo.bits.assign(palabras_por_grupo, 0);  // O(valores_por_grupo / 64)
+    for (uint16_t bajo : grupo.arreglo) {      // O(maximo_en_arreglo)
+        grupo.bits[bajo >> 6] |= uint64_t(1) << (bajo & 63);
+    }
+    vector<uint16_t>().swap(grupo.arreglo);    // libera el arreglo
+}
+// Complejidad: O(valores_por_grupo / 64 + maximo_en_arreglo)
+
+void MapaDeBits::pasar_a_arreglo(Grupo & grupo) {
+    grupo.arreglo.clear();
+    grupo.arreglo.reserve(grupo.cantidad);
+    for (int w = 0; w < palabras_por_grupo; w++) { // O(valores_por_grupo / 64 + cantidad)
+        for (uint64_t palabra = grupo.bits[w]; palabra; palabra &= palabra - 1) {
+            grupo.arreglo.push_back(w * 64 + __builtin_ctzll(palabra));
+        }
+    }
+    vector<uint64_t>().swap(grupo.bits);       // libera los bits
+}
+// Complejidad: O(valores_por_grupo / 64 + cantidad)
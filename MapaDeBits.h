@@ -0,0 +1,44 @@
+#ifndef __MAPADEBITS_H__
+#define __MAPADEBITS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Conjunto de enteros no negativos al estilo de los roaring bitmaps: los valores se
+// agrupan por sus 16 bits altos, y cada grupo se guarda como un arreglo ordenado de sus
+// 16 bits bajos mientras tenga pocos elementos, o como un mapa de 2^16 bits (8 KiB)
+// cuando tiene muchos. Así cada elemento ocupa a lo sumo 2 bytes, y la pertenencia
+// cuesta una búsqueda binaria en a lo sumo 'maximo_en_arreglo' elementos o leer un bit.
+
+class MapaDeBits {
+  public:
+    bool contiene(int x) const; // O(1): O(log maximo_en_arreglo) o leer un bit
+    bool insertar(int x); // O(maximo_en_arreglo) en el peor caso, por el corrimiento
+    bool borrar(int x); // idem
+    int cantidad() const; // O(1)
+    int contar_interseccion(const MapaDeBits & otro) const; // O(Σ min(contenedores)) grupo por grupo
+    size_t bytes() const; // O(g), g = cantidad de grupos
+
+  private:
+    static constexpr int bits_bajos = 16;
+    static constexpr int valores_por_grupo = 1 << bits_bajos;
+    static constexpr int palabras_por_grupo = valores_por_grupo / 64;
+    static constexpr int maximo_en_arreglo = 4096; // a partir de acá los bits ocupan menos
+
+    // Un grupo es un arreglo si 'bits' está vacío, y un mapa de bits si no
+    struct Grupo {
+        vector<uint16_t> arreglo; // ordenado
+        vector<uint64_t> bits; // palabras_por_grupo palabras
+        int cantidad = 0;
+    };
+
+    void pasar_a_bits(Grupo & grupo);
+    void pasar_a_arreglo(Grupo & grupo);
+
+    vector<Grupo> grupos; // x >> bits_bajos -> grupo
+    int total = 0;
+};
+
+#endif
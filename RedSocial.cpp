@@ -1,206 +1,2128 @@
 #include "RedSocial.h"
+#include "Instantanea.h"
+#include "Interseccion.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <numeric>
+#include <queue>
 #include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <string>
 using namespace std;
 
 
-RedSocial::RedSocial() : amistades_count(0), id_mas_popular(-1) {
-    it_conocidos_mas_popular = conocidos.end(); // Iterador inválido inicialmente
+RedSocial::RedSocial(ModoConocidos modo, pmr::memory_resource * memoria) :
+    slots_por_alias(0, HashPorAlias{this}, MismoAlias{this}), amigos(memoria),
+    modo_conocidos(modo), conocidos(memoria), secuencia(0), publicando(false),
+    publicar_todo(true), usuarios_cambiaron(true), amistades_count(0), triangulos_count(0),
+    triangulos_al_dia(true), componentes_count(0), componentes_al_dia(true), id_mas_popular(-1),
+    slot_mas_popular(-1) {
 }
-// Complejidad: O(1), solo inicialización de variables y asignación de iterador
+// Complejidad: O(1), solo inicialización de variables
 
 const set<int> & RedSocial::usuarios() const{
     return this->ids;
 }
 // Complejidad: O(1), retorna referencia directa al set, sin copia ni iteración
 
-string RedSocial::obtener_alias(int id) const{
-    return this->users.at(id);
+string_view RedSocial::obtener_alias(int id) const{
+    return alias_de(slot_de(id));
 }
-// Complejidad: O(log n), búsqueda en map
+// Complejidad: O(1) promedio, búsqueda en unordered_map + acceso a la arena
 
 const set<string> & RedSocial::obtener_amigos(int id) const{
-    return amigos.at(id);
+    INSTRUMENTAR(obtener_amigos);
+    int slot = slot_de(id);                            // O(1) promedio
+    return materializar(vista_amigos[slot], amigos_de(slot));
 }
-// Complejidad: O(log n), búsqueda en map 
+// Complejidad: O(1) promedio si la vista está vigente, O(k log k) si hay que materializarla
+// donde k = grado del usuario
 
 int RedSocial::cantidad_amistades() const{
     return this->amistades_count;
 }
 // Complejidad: O(1), acceso directo a variable mantenida como invariante
 
-void RedSocial::registrar_usuario(string alias, int id){
-    users[id] = alias;                    // O(log n), inserción en map
+void RedSocial::registrar_usuario(string_view alias, int id){
+    INSTRUMENTAR(registrar_usuario);
+    hacer_propio();                       // O(1) salvo la primera vez después de abrir una instantánea
+    // Primero el alias, que lanza length_error si es demasiado largo, antes de tocar nada
+    ArenaDeAlias::Alias lugar = arena_de_alias.guardar(alias); // O(|alias|) amortizado, única copia
+    int slot = nuevo_slot();              // O(1) amortizado
+    id_de_slot[slot] = id;                // O(1)
+    alias_de_slot[slot] = lugar;          // O(1), 4 bytes por slot
+    slot_de_id[id] = slot;                // O(1) promedio, inserción en unordered_map
     ids.insert(id);                       // O(log n), inserción en set
-    amigos[id] = {};                      // O(log n), inserción en map
-    alias_to_id[alias] = id;              // O(1), inserción en unordered_map
-    conocidos[id] = {};                   // O(log n), inserción en map
-
-    // Si es el primer usuario o tiene más amigos que el actual más popular
-    if (id_mas_popular == -1) {
-        id_mas_popular = id;              // O(1)
-        it_conocidos_mas_popular = conocidos.find(id); // O(log n), búsqueda en map
+    slots_por_alias.insert(slot);         // O(|alias|) promedio, el alias se lee de la arena
+    poner_en_grado(slot, 0);              // O(log n), todavía no tiene amigos
+    if (componentes_al_dia) {
+        poner_en_componente(slot, nueva_componente()); // O(1) amortizado, solo en la suya
     }
+    marcar_para_publicar(slot);           // O(1) amortizado
+    usuarios_cambiaron = true;
+
+    // Con cero amigos sólo pasa a ser el más popular si nadie tiene amigos y su id es el menor
+    recalcular_mas_popular();             // O(1) promedio
+    anotar(Bitacora::registro_usuario, id, -1, alias); // O(|alias|) amortizado
 }
-// Complejidad: O(log n) + O(1)
+// Complejidad: O(log n) + O(1) promedio
 
 void RedSocial::eliminar_usuario(int id){
-    // Guardar amigos antes de eliminar
-    vector<string> amigos_a_eliminar;
-    for(auto amigo : amigos[id]){               // O(k) donde k = grado del usuario
-        amigos_a_eliminar.push_back(amigo);     // O(1) por inserción
+    INSTRUMENTAR(eliminar_usuario);
+    hacer_propio();                             // O(1) salvo la primera vez después de abrir una instantánea
+    int slot = slot_de(id);                     // O(1) promedio
+    const ListaDeAmigos& sus_amigos = amigos[slot];
+
+    // El usuario deja de ser amigo en común entre cada par de sus amigos que no son amigos
+    // entre sí; los que sí lo son pierden el triángulo que cerraban con él
+    for (int f : sus_amigos) {                  // O(k) iteraciones donde k = grado del usuario
+        for (int w : sus_amigos) {              // O(k) iteraciones
+            if (w == f) continue;
+            if (!es_amigo(f, w)) {              // O(1) si f tiene índice, sino O(log |amigos[f]|)
+                ajustar_conocido(f, w, -1);     // O(1) promedio, el par (w, f) se ajusta en su vuelta
+            } else if (triangulos_al_dia) {
+                triangulos_de_slot[f]--;        // O(1), el triángulo (slot, f, w); w se descuenta en su vuelta
+            }
+        }
+    }
+    if (triangulos_al_dia) {
+        triangulos_count -= triangulos_de_slot[slot];
+        triangulos_de_slot[slot] = 0;
+    }
+
+    // Sus conocidos dejan de conocerlo. Si los conocidos del usuario no están al día, se los
+    // encuentra recorriendo los amigos de sus amigos
+    if (conocidos_al_dia[slot]) {
+        for (const auto& [v, en_comun] : conocidos[slot]) { // O(c) donde c = cantidad de conocidos
+            fijar_conocido(v, slot, 0);         // O(1) promedio
+        }
+    } else {
+        for (int f : sus_amigos) {              // O(k) iteraciones
+            for (int v : amigos[f]) {           // O(|amigos[f]|) iteraciones
+                if (v != slot && !es_amigo(slot, v)) { // O(1) con índice, sino O(log k)
+                    fijar_conocido(v, slot, 0); // O(1) promedio
+                }
+            }
+        }
+    }
+
+    // Sus amigos dejan de tenerlo como amigo
+    for (int f : sus_amigos) {                  // O(k) iteraciones
+        quitar_amigo(f, slot);                  // O(|amigos[f]|)
+        mover_de_grado(f, amigos[f].size() + 1, amigos[f].size()); // O(log n)
+        vista_amigos[f].vigente = false;        // O(1)
+        marcar_para_publicar(f);                // O(1) amortizado
     }
-    
-    // Desamigar de todos sus amigos
-    for(auto amigo_alias : amigos_a_eliminar){  // O(k) iteraciones
-        desamigar_usuarios(id, obtener_id(amigo_alias)); // O(k*n) en peor caso
+    amistades_count -= sus_amigos.size();       // O(1)
+    sacar_de_grado(slot, sus_amigos.size());    // O(log n)
+
+    // Su componente lo pierde, y puede quedar partida en tantos pedazos como amigos tenía
+    if (componentes_al_dia) {
+        sacar_de_componente(slot);              // O(1)
+        separar_componente(sus_amigos);         // ver separar_componente
     }
-    
+
     // Eliminar todas las estructuras del usuario
-    string alias = users[id];                   // O(log n), búsqueda en map
-    alias_to_id.erase(alias);                   // O(1), borrado de unordered_map
-    users.erase(id);                            // O(log n), borrado de map
+    amigos[slot].clear();                       // O(k)
+    indice_de_amigos[slot].reset();
+    conocidos[slot].clear();                    // O(c)
+    conocidos_al_dia[slot] = true;              // O(1), vacío es correcto para un slot libre
+    slots_por_alias.erase(slot);                // O(|alias|) promedio, antes de liberar el alias
+    arena_de_alias.liberar(alias_de_slot[slot]); // O(1) amortizado
+    slot_de_id.erase(id);                       // O(1) promedio, borrado de unordered_map
     ids.erase(id);                              // O(log n), borrado de set
-    amigos.erase(id);                           // O(log n), borrado de map
-    conocidos.erase(id);                        // O(log n), borrado de map
+    id_de_slot[slot] = -1;                      // O(1)
+    alias_de_slot[slot] = ArenaDeAlias::ninguno; // O(1)
+    invalidar_vistas(slot);                     // O(1) amortizado
+    usuarios_cambiaron = true;
+    slots_libres.push_back(slot);               // O(1) amortizado
 
-    // Si eliminamos al más popular, recalcular
-    if (id == id_mas_popular) {
-        recalcular_mas_popular();               // O(n), recorre todos los usuarios
-    }
+    // Una sola vez, al final: el más popular pudo ser el eliminado o alguno de sus amigos
+    recalcular_mas_popular();                   // O(1), es el primero del ranking
+    anotar(Bitacora::baja_usuario, id, -1);     // O(1) amortizado
 }
-// Complejidad: Sin requerimiento, pero es O(k*n) donde k es el grado del usuario eliminado
+// Complejidad: Sin requerimiento, pero es O(k^2 log k + Σ |amigos[f]| + c + log n) donde k es el
+// grado del usuario eliminado, f recorre sus amigos y c es la cantidad de sus conocidos; si sus
+// conocidos no estaban al día, O(k^2 log k + Σ |amigos[f]| log k + log n)
 
 void RedSocial::amigar_usuarios(int id_A, int id_B){
-    string alias_A = users[id_A];              // O(log n), búsqueda en map
-    string alias_B = users[id_B];              // O(log n), búsqueda en map
-    
+    INSTRUMENTAR(amigar_usuarios);
+    hacer_propio();                            // O(1) salvo la primera vez después de abrir una instantánea
+    int a = slot_de(id_A);                     // O(1) promedio
+    int b = slot_de(id_B);                     // O(1) promedio
+
+    // A y B ya no pueden ser conocidos entre sí
+    fijar_conocido(a, b, 0);                   // O(1) promedio
+    fijar_conocido(b, a, 0);                   // O(1) promedio
+
     // Agregar amistad bidireccional
-    amigos[id_A].insert(alias_B);              // O(log |amigos[id_A]|), inserción en set
-    amigos[id_B].insert(alias_A);              // O(log |amigos[id_B]|), inserción en set
+    agregar_amigo(a, b);                       // O(|amigos[a]|), inserción en vector ordenado
+    agregar_amigo(b, a);                       // O(|amigos[b]|)
+    mover_de_grado(a, amigos[a].size() - 1, amigos[a].size()); // O(log n)
+    mover_de_grado(b, amigos[b].size() - 1, amigos[b].size()); // O(log n)
+    invalidar_vistas(a);                       // O(1)
+    invalidar_vistas(b);                       // O(1)
     this->amistades_count += 1;                // O(1)
 
-    // A y B ya no pueden ser conocidos entre sí
-    conocidos[id_A].erase(alias_B);            // O(log |conocidos[id_A]|), borrado en set
-    conocidos[id_B].erase(alias_A);            // O(log |conocidos[id_B]|), borrado en set
+    // B pasa a ser amigo en común entre A y cada amigo de B, y viceversa
+    ajustar_amigo_en_comun(a, b, +1);          // O(|amigos[b]| log |amigos[a]|)
+    ajustar_amigo_en_comun(b, a, +1);          // O(|amigos[a]| log |amigos[b]|)
+    if (componentes_al_dia) {
+        unir_componentes(a, b);                // O(tamaño de la menor)
+    }
+
+    // Recalcular el más popular (pueden haber cambiado las cantidades de amigos)
+    recalcular_mas_popular();                  // O(1), es el primero del ranking
+    anotar(Bitacora::alta_amistad, id_A, id_B); // O(1) amortizado
+}
+// Complejidad: Sin requerimiento, pero es O(k log k) donde k es el máximo grado entre A y B
+
+void RedSocial::desamigar_usuarios(int id_A, int id_B){
+    INSTRUMENTAR(desamigar_usuarios);
+    hacer_propio();                            // O(1) salvo la primera vez después de abrir una instantánea
+    int a = slot_de(id_A);                     // O(1) promedio
+    int b = slot_de(id_B);                     // O(1) promedio
+
+    // Cortar amistad bidireccional
+    quitar_amigo(a, b);                        // O(|amigos[a]|), borrado en vector ordenado
+    quitar_amigo(b, a);                        // O(|amigos[b]|)
+    mover_de_grado(a, amigos[a].size() + 1, amigos[a].size()); // O(log n)
+    mover_de_grado(b, amigos[b].size() + 1, amigos[b].size()); // O(log n)
+    invalidar_vistas(a);                       // O(1)
+    invalidar_vistas(b);                       // O(1)
+    amistades_count -= 1;                      // O(1)
+
+    // B deja de ser amigo en común entre A y cada amigo de B, y viceversa
+    ajustar_amigo_en_comun(a, b, -1);          // O(|amigos[b]| log |amigos[a]|)
+    ajustar_amigo_en_comun(b, a, -1);          // O(|amigos[a]| log |amigos[b]|)
+    if (componentes_al_dia) {
+        int extremos[] = {a, b};
+        separar_componente(extremos);          // hasta que se encuentren o se acabe un lado
+    }
+
+    // A y B siguen siendo conocidos si les queda algún amigo en común (a los perezosos
+    // alcanza con desactualizarlos, no hace falta contar)
+    int en_comun = 0;
+    if (conocidos_ansiosos[a] || conocidos_ansiosos[b]) {
+        en_comun = contar_en_comun(a, b);      // O(|amigos[a]| + |amigos[b]|) o menos
+    }
+    fijar_conocido(a, b, en_comun);            // O(1) promedio
+    fijar_conocido(b, a, en_comun);            // O(1) promedio
+
+    // Recalcular el más popular
+    recalcular_mas_popular();                  // O(1), es el primero del ranking
+    anotar(Bitacora::baja_amistad, id_A, id_B); // O(1) amortizado
+}
+// Complejidad: Sin requerimiento, O(k log k) donde k es el máximo grado entre A y B
+
+int RedSocial::obtener_id(string_view alias) const{
+    auto it = slots_por_alias.find(alias);     // O(|alias|) promedio, sin armar un string
+    if (it == slots_por_alias.end()) {
+        throw out_of_range("alias no registrado");
+    }
+    return id_de_slot[*it];
+}
+// Complejidad: O(1)
+
+const set<string> & RedSocial::obtener_conocidos(int id) const{
+    INSTRUMENTAR(obtener_conocidos);
+    int slot = slot_de(id);                            // O(1) promedio
+    return materializar(vista_conocidos[slot], conocidos_al_dia_de(slot));
+}
+// Complejidad: O(1) promedio si la vista está vigente, O(c log c) si hay que materializarla
+// donde c = cantidad de conocidos; en un slot perezoso desactualizado, además O(grado^2 log grado)
+
+const set<string> & RedSocial::conocidos_del_usuario_mas_popular() const{
+    INSTRUMENTAR(conocidos_del_usuario_mas_popular);
+    static const set<string> vacio;
+    if (slot_mas_popular == -1) {
+        return vacio;                          // O(1), no hay usuarios
+    }
+    return materializar(vista_conocidos[slot_mas_popular], conocidos_al_dia_de(slot_mas_popular));
+}
+// Complejidad: O(1) si la vista está vigente, O(c log c) si hay que materializarla; si el más
+// popular es perezoso y está desactualizado, además O(grado^2 log grado)
+
+vector<int> RedSocial::mas_populares(int k) const{
+    vector<int> resultado;
+    resultado.reserve(min<size_t>(max(k, 0), ranking.size()));
+    for (auto it = ranking.begin(); it != ranking.end() && (int)resultado.size() < k; ++it) { // O(k) amortizado
+        resultado.push_back(it->second);
+    }
+    return resultado;
+}
+// Complejidad: O(k), recorrido en orden desde el primero del ranking
+
+int RedSocial::puesto_por_grado(int id) const{
+    int slot = slot_de(id);                    // O(1) promedio
+    return ranking.order_of_key({-(int)amigos_de(slot).size(), id}) + 1; // O(log n), tamaños de subárbol
+}
+// Complejidad: O(log n)
 
-    // Actualizar conocidos: los amigos de B (excepto A) son conocidos de A si no son amigos directos
-    for(auto amigo_de_B : amigos[id_B]){       // O(|amigos[id_B]|)
-        if(amigo_de_B != alias_A){
-            int id_amigo_de_B = obtener_id(amigo_de_B);     // O(1), búsqueda en unordered_map
-            // Si no es amigo directo de A, entonces son conocidos
-            if(amigos[id_A].count(amigo_de_B) == 0){        // O(log |amigos[id_A]|), búsqueda en set
-                conocidos[id_A].insert(amigo_de_B);         // O(log |conocidos[id_A]|), inserción en set
-                conocidos[id_amigo_de_B].insert(alias_A);   // O(log |conocidos[id_amigo_de_B]|), inserción en set
+vector<int> RedSocial::amigos_en_comun(int id_A, int id_B) const{
+    int a = slot_de(id_A);                     // O(1) promedio
+    int b = slot_de(id_B);                     // O(1) promedio
+    if (amigos_de(a).size() > amigos_de(b).size()) swap(a, b);
+    vector<int> en_comun;
+    if (indice_de_amigos[b] && !indice_de_amigos[a]) {
+        // B es un hub y A no: se busca cada amigo de A en el índice de B
+        for (int s : amigos_de(a)) {           // O(k_A)
+            if (indice_de_amigos[b]->contiene(s)) en_comun.push_back(s);
+        }
+    } else {
+        intersectar(amigos_de(a), amigos_de(b), en_comun); // O(k_A + k_B), vectorizado o galopando
+    }
+    for (int& s : en_comun) {                  // O(r), de slots a ids
+        s = id_de_slot[s];
+    }
+    sort(en_comun.begin(), en_comun.end());    // O(r log r)
+    return en_comun;
+}
+// Complejidad: O(k_A + k_B + r log r), u O(k_chico log k_grande + r log r) si los grados son muy
+// distintos, u O(k_chico + r log r) si sólo el más grande es un hub, donde r es la cantidad de
+// amigos en común
+
+int RedSocial::cantidad_amigos_en_comun(int id_A, int id_B) const{
+    int a = slot_de(id_A);                     // O(1) promedio
+    int b = slot_de(id_B);                     // O(1) promedio
+    // Si A está al día y B es su conocido, la cantidad ya está contada
+    if (conocidos_al_dia[a]) {
+        auto it = conocidos[a].find(b);        // O(1) promedio
+        if (it != conocidos[a].end()) return it->second;
+    }
+    return contar_en_comun(a, b);              // O(k_A + k_B) o menos
+}
+// Complejidad: O(1) promedio si A tiene sus conocidos al día y B es uno de ellos; si no, la de
+// contar_en_comun
+
+vector<pair<int, int>> RedSocial::recomendar_conocidos(int id, int n, span<const int> excluidos) const{
+    int slot = slot_de(id);                    // O(1) promedio
+    if (n <= 0) return {};
+    unordered_set<int> slots_excluidos;
+    for (int e : excluidos) {                  // O(e) promedio
+        auto it = slot_de_id.find(e);
+        if (it != slot_de_id.end()) slots_excluidos.insert(it->second);
+    }
+
+    // Heap de mínimos por relevancia: arriba queda el peor de los n mejores vistos hasta ahora
+    auto mas_relevante = [&](pair<int, int> x, pair<int, int> y) { // pares (en común, slot)
+        if (x.first != y.first) return x.first > y.first;
+        return id_de_slot[x.second] < id_de_slot[y.second];
+    };
+    vector<pair<int, int>> heap;
+    heap.reserve(n);
+    auto considerar = [&](int v, int en_comun) {
+        if (slots_excluidos.count(v)) return;  // O(1) promedio
+        if ((int)heap.size() < n) {
+            heap.push_back({en_comun, v});
+            push_heap(heap.begin(), heap.end(), mas_relevante); // O(log n)
+        } else if (mas_relevante({en_comun, v}, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), mas_relevante); // O(log n)
+            heap.back() = {en_comun, v};
+            push_heap(heap.begin(), heap.end(), mas_relevante);
+        }
+    };
+
+    // Con una instantánea abierta que guardó sus conocidos se leen directo del archivo
+    if (!conocidos_al_dia[slot] && respaldo && respaldo->tiene_conocidos(slot)) {
+        for (auto [v, en_comun] : respaldo->conocidos(slot)) { // O(c log n)
+            considerar(v, en_comun);
+        }
+    } else {
+        for (const auto& [v, en_comun] : conocidos_al_dia_de(slot)) { // O(c log n)
+            considerar(v, en_comun);
+        }
+    }
+
+    sort_heap(heap.begin(), heap.end(), mas_relevante); // O(n log n), del más relevante al menos
+    vector<pair<int, int>> recomendados;
+    recomendados.reserve(heap.size());
+    for (auto [en_comun, v] : heap) {
+        recomendados.push_back({id_de_slot[v], en_comun});
+    }
+    return recomendados;
+}
+// Complejidad: O(c log n + e) promedio donde c = cantidad de conocidos y e = |excluidos|; si el
+// usuario es perezoso y está desactualizado, además O(grado^2 log grado)
+
+int RedSocial::distancia(int id_A, int id_B) const{
+    INSTRUMENTAR(distancia);
+    int a = slot_de(id_A), b = slot_de(id_B); // O(1) promedio; lanza out_of_range si no existen
+    if (a == b) return 0;
+
+    // nivel_de_slot guarda d + 1 para los alcanzados desde A a distancia d, y -(d + 1) para
+    // los alcanzados desde B. Cada paso expande un nivel entero de un solo lado; si alguno
+    // de los nuevos ya lo había alcanzado el otro lado, el camino más corto pasa por el
+    // mejor de ellos, y no puede haber uno más corto que no se haya cruzado antes
+    const uint32_t epoca = nueva_epoca();      // O(1) amortizado
+    epoca_de_slot[a] = epoca_de_slot[b] = epoca;
+    nivel_de_slot[a] = 1;
+    nivel_de_slot[b] = -1;
+    vector<int> frontera_a = {a}, frontera_b = {b}, siguiente;
+    long long aristas_a = amigos_de(a).size(), aristas_b = amigos_de(b).size();
+    int nivel_a = 0, nivel_b = 0;
+    while (!frontera_a.empty() && !frontera_b.empty()) {
+        bool desde_a = aristas_a <= aristas_b; // el lado más barato de expandir
+        vector<int> & frontera = desde_a ? frontera_a : frontera_b;
+        int signo = desde_a ? 1 : -1;
+        int nivel = desde_a ? ++nivel_a : ++nivel_b;
+        int mejor = -1;
+        long long aristas = 0;
+        siguiente.clear();
+        for (int v : frontera) {               // O(Σ grado de la frontera)
+            for (int w : amigos_de(v)) {
+                if (epoca_de_slot[w] != epoca) {
+                    epoca_de_slot[w] = epoca;
+                    nivel_de_slot[w] = signo * (nivel + 1);
+                    siguiente.push_back(w);
+                    aristas += amigos_de(w).size();
+                } else if (nivel_de_slot[w] * signo < 0) { // lo alcanzó el otro lado
+                    int largo = nivel + abs(nivel_de_slot[w]) - 1;
+                    if (mejor == -1 || largo < mejor) mejor = largo;
+                }
             }
         }
+        if (mejor != -1) return mejor;
+        swap(frontera, siguiente);
+        (desde_a ? aristas_a : aristas_b) = aristas;
     }
+    return -1;                                 // uno de los lados se quedó sin nadie nuevo
+}
+// Complejidad: O(Σ grado de los usuarios expandidos), que en redes con pocos grados de
+// separación es mucho menos que recorrer todo desde un extremo
+
+vector<int> RedSocial::vecindario(int id, int k, int cantidad_hilos) const{
+    INSTRUMENTAR(vecindario);
+    int origen = slot_de(id);                  // O(1) promedio; lanza out_of_range si no existe
+    vector<int> resultado;
+    if (k <= 0) return resultado;
 
-    // Actualizar conocidos: los amigos de A (excepto B) son conocidos de B si no son amigos directos
-    for(auto amigo_de_A : amigos[id_A]){       // O(|amigos[id_A]|)
-        if(amigo_de_A != alias_B){
-            int id_amigo_de_A = obtener_id(amigo_de_A);     // O(1) promedio
-            // Si no es amigo directo de B, entonces son conocidos
-            if(amigos[id_B].count(amigo_de_A) == 0){        // O(log |amigos[id_B]|)
-                conocidos[id_B].insert(amigo_de_A);         // O(log |conocidos[id_B]|)
-                conocidos[id_amigo_de_A].insert(alias_B);   // O(log |conocidos[id_amigo_de_A]|)
+    // Se cambia de arriba-abajo (recorrer las amistades de la frontera) a abajo-arriba
+    // (buscar, para cada no visitado, algún amigo en la frontera) cuando la frontera tiene
+    // más de 1/alfa de las amistades sin visitar, y se vuelve cuando tiene menos de 1/beta
+    // de los usuarios: abajo-arriba cuesta O(n) por nivel, pero cada no visitado deja de
+    // mirar amigos en cuanto encuentra uno en la frontera
+    const int alfa = 14, beta = 24;
+    const int slots_por_hilo = 1024;           // menos que esto no compensa lanzar un hilo
+    const int n = id_de_slot.size();
+    const uint32_t epoca = nueva_epoca();      // O(1) amortizado
+    epoca_de_slot[origen] = epoca;
+    vector<int> frontera = {origen}, visitados;
+    vector<uint64_t> en_frontera;
+    long long aristas_frontera = amigos_de(origen).size();
+    long long aristas_sin_visitar = 2LL * amistades_count - aristas_frontera;
+    bool abajo_arriba = false;
+
+    for (int nivel = 1; nivel <= k && !frontera.empty(); nivel++) {
+        if (!abajo_arriba) {
+            abajo_arriba = aristas_frontera > aristas_sin_visitar / alfa;
+        } else {
+            abajo_arriba = (long long)frontera.size() * beta >= (long long)ids.size();
+        }
+        vector<int> siguiente;
+        if (!abajo_arriba) {
+            for (int v : frontera) {           // O(aristas_frontera)
+                for (int w : amigos_de(v)) {
+                    if (epoca_de_slot[w] == epoca) continue;
+                    epoca_de_slot[w] = epoca;
+                    siguiente.push_back(w);
+                }
             }
+        } else {
+            en_frontera.assign((n + 63) / 64, 0); // O(n / 64)
+            for (int v : frontera) en_frontera[v / 64] |= 1ull << (v % 64);
+
+            // Cada hilo revisa un tramo de slots y sólo escribe los suyos; después se
+            // concatenan los encontrados
+            int hilos = max(1, min(cantidad_hilos, n / slots_por_hilo));
+            vector<vector<int>> encontrados(hilos);
+            auto revisar = [&](int h) {
+                for (int u = (long long)n * h / hilos; u < (long long)n * (h + 1) / hilos; u++) {
+                    if (epoca_de_slot[u] == epoca) continue;
+                    for (int f : amigos_de(u)) { // hasta el primer amigo en la frontera
+                        if (en_frontera[f / 64] >> (f % 64) & 1) {
+                            epoca_de_slot[u] = epoca;
+                            encontrados[h].push_back(u);
+                            break;
+                        }
+                    }
+                }
+            };
+            vector<thread> trabajadores;
+            for (int h = 1; h < hilos; h++) trabajadores.emplace_back(revisar, h);
+            revisar(0);                        // O((n + aristas sin visitar) / hilos)
+            for (auto& trabajador : trabajadores) trabajador.join();
+            for (auto& parte : encontrados) siguiente.insert(siguiente.end(), parte.begin(), parte.end());
         }
+        aristas_frontera = 0;
+        for (int w : siguiente) aristas_frontera += amigos_de(w).size(); // O(|siguiente|)
+        aristas_sin_visitar -= aristas_frontera;
+        visitados.insert(visitados.end(), siguiente.begin(), siguiente.end());
+        frontera = std::move(siguiente);
     }
 
-    // Recalcular el más popular (pueden haber cambiado las cantidades de amigos)
-    recalcular_mas_popular();                  // O(n) - recorre todos los usuarios
+    resultado.reserve(visitados.size());
+    for (int s : visitados) resultado.push_back(id_de_slot[s]); // O(r)
+    sort(resultado.begin(), resultado.end()); // O(r log r)
+    return resultado;
 }
-// Complejidad: Sin requerimiento, pero esO(k*log n + n) donde k es el máximo entre id_A e id_B
+// Complejidad: O(Σ grado de los visitados + r log r) con todos los niveles arriba-abajo; cada
+// nivel abajo-arriba es O(n + amistades sin visitar), repartido entre los hilos
 
-void RedSocial::desamigar_usuarios(int id_A, int id_B){
-    string alias_A = users[id_A];              // O(log n), búsqueda en map
-    string alias_B = users[id_B];              // O(log n), búsqueda en map
+long long RedSocial::triangulos(int id) const{
+    int slot = slot_de(id);                    // O(1) promedio
+    if (!triangulos_al_dia) contar_triangulos(0); // sólo la primera vez después de abrir una instantánea
+    return triangulos_de_slot[slot];
+}
+// Complejidad: O(1) promedio si están al día, sino lo que cuesta contar_triangulos
 
-    // Guardar amigos previos a cortar la amistad
-    auto amigos_A_antes = amigos[id_A];        // O(|amigos[id_A]|), copia del set
-    auto amigos_B_antes = amigos[id_B];        // O(|amigos[id_B]|),  copia del set
+double RedSocial::coeficiente_de_agrupamiento(int id) const{
+    long long k = amigos_de(slot_de(id)).size(); // O(1) promedio
+    if (k < 2) return 0;
+    return triangulos(id) / (k * (k - 1) / 2.0); // sobre los pares de amigos posibles
+}
+// Complejidad: la de triangulos
 
-    // Cortar amistad bidireccional
-    amigos[id_A].erase(alias_B);               // O(log |amigos[id_A]|), borrado en set
-    amigos[id_B].erase(alias_A);               // O(log |amigos[id_B]|), borrado en set
-    amistades_count -= 1;                      // O(1)
+long long RedSocial::cantidad_triangulos() const{
+    if (!triangulos_al_dia) contar_triangulos(0);
+    return triangulos_count;
+}
+// Complejidad: O(1) si están al día
+
+double RedSocial::coeficiente_de_agrupamiento_global() const{
+    long long caminos = 0;                     // caminos de largo 2, v - s - w
+    for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n)
+        long long k = amigos_de(s).size();
+        caminos += k * (k - 1) / 2;
+    }
+    return caminos == 0 ? 0 : 3.0 * cantidad_triangulos() / caminos;
+}
+// Complejidad: O(n) si están al día
+
+bool RedSocial::misma_componente(int id_A, int id_B) const{
+    int a = slot_de(id_A), b = slot_de(id_B); // O(1) promedio
+    if (!componentes_al_dia) contar_componentes(0); // sólo la primera vez después de abrir una instantánea
+    return componente_de_slot[a] == componente_de_slot[b];
+}
+// Complejidad: O(1) promedio si están al día, sino lo que cuesta contar_componentes
+
+int RedSocial::tamanio_de_componente(int id) const{
+    int slot = slot_de(id);                    // O(1) promedio
+    if (!componentes_al_dia) contar_componentes(0);
+    return miembros_de_componente[componente_de_slot[slot]].size();
+}
+// Complejidad: O(1) promedio si están al día
 
-    // Conjunto de usuarios afectados que necesitan reconstruir sus conocidos
-    set<int> afectados;                        // O(1)
-    afectados.insert(id_A);                    // O(log |afectados|) = O(1) inicialmente
-    afectados.insert(id_B);                    // O(log |afectados|) = O(1) 
-    for (const auto& aliasX : amigos_A_antes) afectados.insert(obtener_id(aliasX)); // O(k_A * log k) donde k_A = |amigos_A_antes|
-    for (const auto& aliasY : amigos_B_antes) afectados.insert(obtener_id(aliasY)); // O(k_B * log k) donde k_B = |amigos_B_antes|
+int RedSocial::cantidad_componentes() const{
+    if (!componentes_al_dia) contar_componentes(0);
+    return componentes_count;
+}
+// Complejidad: O(1) si están al día
 
-    // Reconstruir conocidos de todos los afectados
-    for (int id : afectados) {                 // O(k) iteraciones donde k = |afectados|
-        reconstruir_conocidos_de(id);          // O(grado^2) por usuario
+RedSocial::RangoDeAmigos RedSocial::amigos_desde(int id, uint64_t ficha) const{
+    span<const int> lista = amigos_de(slot_de(id)); // O(1) promedio
+    // La ficha es el primer slot que falta devolver
+    auto desde = lower_bound(lista.begin(), lista.end(), (int64_t)ficha); // O(log k)
+    return RangoDeAmigos(lista.subspan(desde - lista.begin()), IdDeSlot{this});
+}
+// Complejidad: O(log k), k = grado del usuario
+
+RedSocial::RangoDeConocidos RedSocial::conocidos_desde(int id, uint64_t ficha) const{
+    return RangoDeConocidos(this, slot_de(id), ficha);
+}
+// Complejidad: la del constructor de RangoDeConocidos
+
+RedSocial::Pagina RedSocial::pagina_de_amigos(int id, int limite, uint64_t ficha) const{
+    RangoDeAmigos rango = amigos_desde(id, ficha); // O(log k)
+    Pagina pagina;
+    for (int amigo : rango | views::take(limite)) { // O(limite)
+        pagina.ids.push_back(amigo);
     }
+    span<const int> resto = rango.base().subspan(pagina.ids.size());
+    pagina.hay_mas = !resto.empty();
+    pagina.siguiente = pagina.hay_mas ? resto.front() : 0;
+    return pagina;
+}
+// Complejidad: O(log k + limite)
 
-    // Recalcular el más popular
-    recalcular_mas_popular();                  // O(n) - recorre todos los usuarios
+RedSocial::Pagina RedSocial::pagina_de_conocidos(int id, int limite, uint64_t ficha) const{
+    RangoDeConocidos rango = conocidos_desde(id, ficha);
+    Pagina pagina;
+    auto it = rango.begin();
+    for (; it != rango.end() && (int)pagina.ids.size() < limite; ++it) {
+        pagina.ids.push_back(*it);
+    }
+    pagina.hay_mas = it != rango.end();
+    pagina.siguiente = pagina.hay_mas ? it.ficha() : 0;
+    return pagina;
+}
+// Complejidad: O(log k) más lo que cueste avanzar hasta el conocido siguiente al último de la
+// página (ver RangoDeConocidos::iterador::avanzar)
+
+RedSocial::RangoDeConocidos::RangoDeConocidos(const RedSocial * red, int slot, uint64_t ficha) {
+    inicio.red = red;
+    inicio.slot = slot;
+    inicio.amigos_u = red->amigos_de(slot);
+    // La ficha es (slot del amigo en común, slot del conocido): se retoma en el primer par
+    // que no sea anterior, aunque alguno de los dos ya no esté en su lista
+    int amigo = ficha >> 32, conocido = (uint32_t)ficha;
+    auto it = lower_bound(inicio.amigos_u.begin(), inicio.amigos_u.end(), amigo); // O(log k)
+    inicio.i = it - inicio.amigos_u.begin();
+    if (it != inicio.amigos_u.end() && *it == amigo) {
+        span<const int> de_f = red->amigos_de(amigo);
+        inicio.j = lower_bound(de_f.begin(), de_f.end(), conocido) - de_f.begin(); // O(log |amigos[f]|)
+    }
+    inicio.avanzar();
 }
-// Complejidad: Sin requerimiento, O(k*grado^2 + n) donde k es el número de usuarios afectados
+// Complejidad: O(log k + log |amigos[f]|) más avanzar hasta el primer conocido
 
-int RedSocial::obtener_id(string alias) const{
-    return alias_to_id.at(alias);              // O(1), búsqueda en unordered_map
+RedSocial::RangoDeConocidos::iterador RedSocial::RangoDeConocidos::begin() const{
+    return inicio;
 }
 // Complejidad: O(1)
 
-const set<string> & RedSocial::obtener_conocidos(int id) const{  
-    return conocidos.at(id);                    // O(log n), búsqueda en map
+int RedSocial::RangoDeConocidos::iterador::operator*() const{
+    return red->id_de_slot[red->amigos_de(amigos_u[i])[j]];
 }
-// Complejidad: O(log n)
+// Complejidad: O(1)
 
-const set<string> & RedSocial::conocidos_del_usuario_mas_popular() const{
-    return it_conocidos_mas_popular->second;   // O(1)
+RedSocial::RangoDeConocidos::iterador & RedSocial::RangoDeConocidos::iterador::operator++(){
+    j++;
+    avanzar();
+    return *this;
 }
-// Complejidad: O(1) 
+// Complejidad: la de avanzar
+
+bool RedSocial::RangoDeConocidos::iterador::operator==(default_sentinel_t) const{
+    return i >= amigos_u.size();
+}
+// Complejidad: O(1)
+
+uint64_t RedSocial::RangoDeConocidos::iterador::ficha() const{
+    return (uint64_t)amigos_u[i] << 32 | (uint32_t)red->amigos_de(amigos_u[i])[j];
+}
+// Complejidad: O(1)
+
+void RedSocial::RangoDeConocidos::iterador::avanzar(){
+    // Recorre los caminos u - f - w desde (i, j) hasta uno cuyo w sea conocido de u y cuyo f
+    // sea el primer amigo en común entre ambos, así cada conocido sale una sola vez
+    for (; i < amigos_u.size(); i++, j = 0) {
+        span<const int> de_f = red->amigos_de(amigos_u[i]);
+        for (; j < de_f.size(); j++) {         // O(|amigos[f]|) iteraciones
+            int w = de_f[j];
+            if (w != slot && !red->es_amigo(slot, w) && es_primera_vez(w)) return;
+        }
+    }
+}
+// Complejidad: O(Σ caminos recorridos * (1 + min(i, |amigos[w]|))) en el peor caso; los conocidos
+// que salen del primer amigo cuestan O(1) con índice, u O(log k) sin él
+
+bool RedSocial::RangoDeConocidos::iterador::es_primera_vez(int w) const{
+    // Ningún amigo de u anterior a amigos_u[i] es amigo de w: se revisa el lado más corto
+    span<const int> anteriores = amigos_u.first(i);
+    span<const int> de_w = red->amigos_de(w);
+    span<const int> de_w_anteriores = de_w.first(lower_bound(de_w.begin(), de_w.end(), amigos_u[i]) - de_w.begin());
+    if (anteriores.size() <= de_w_anteriores.size()) {
+        for (int x : anteriores) {             // O(i) pertenencias
+            if (red->es_amigo(w, x)) return false;
+        }
+    } else {
+        for (int x : de_w_anteriores) {        // O(|de_w_anteriores|) pertenencias
+            if (red->es_amigo(slot, x)) return false;
+        }
+    }
+    return true;
+}
+// Complejidad: O(min(i, |amigos[w]|)) pertenencias, cada una O(1) con índice u O(log) sin él
+
+
+RedSocial::Transaccion RedSocial::transaccion() {
+    return Transaccion(*this);
+}
+// Complejidad: O(1)
+
+void RedSocial::Transaccion::amigar_usuarios(int id_A, int id_B) {
+    if (id_A == id_B) return;                  // nadie es amigo de sí mismo
+    quedan_amigos[clave_de_par(id_A, id_B)] = true; // O(1) promedio, pisa el cambio anterior
+}
+// Complejidad: O(1) promedio
+
+void RedSocial::Transaccion::desamigar_usuarios(int id_A, int id_B) {
+    if (id_A == id_B) return;
+    quedan_amigos[clave_de_par(id_A, id_B)] = false; // O(1) promedio
+}
+// Complejidad: O(1) promedio
+
+int RedSocial::Transaccion::pendientes() const {
+    return quedan_amigos.size();
+}
+// Complejidad: O(1)
+
+void RedSocial::Transaccion::confirmar() {
+    if (quedan_amigos.empty()) return;         // O(1), nada que aplicar
+    // Primero se traducen todos los ids, que es lo único que puede fallar: si alguno no
+    // existe, la red queda como estaba y la transacción conserva sus cambios
+    unordered_map<uint64_t, bool> por_slots;
+    por_slots.reserve(quedan_amigos.size());
+    for (auto [clave, amigos_al_final] : quedan_amigos) { // O(p) promedio
+        int a = red->slot_de(clave >> 32), b = red->slot_de((uint32_t)clave); // lanza out_of_range
+        por_slots[clave_de_par(a, b)] = amigos_al_final;
+    }
+    quedan_amigos.clear();
+
+    red->hacer_propio();                       // O(n + m + Σ c) la primera vez después de abrir una instantánea
+    vector<pair<int, int>> altas, bajas;
+    red->cambios_netos(por_slots, altas, bajas); // O(p log grado)
+    red->aplicar_cambios_de_amistad(altas, bajas);
+    for (auto [a, b] : altas) {                // O(p) amortizado
+        red->anotar(Bitacora::alta_amistad, red->id_de_slot[a], red->id_de_slot[b]);
+    }
+    for (auto [a, b] : bajas) {
+        red->anotar(Bitacora::baja_amistad, red->id_de_slot[a], red->id_de_slot[b]);
+    }
+}
+// Complejidad: O(p log grado) más aplicar_cambios_de_amistad sobre los cambios netos, en vez
+// de un ajuste de conocidos y un recálculo del más popular por cada cambio anotado
+
+void RedSocial::Transaccion::descartar() {
+    quedan_amigos.clear();
+}
+// Complejidad: O(p)
+
+void RedSocial::cargar_en_bloque(const vector<pair<string, int>> & nuevos_usuarios,
+                                 const vector<pair<int, int>> & nuevas_amistades){
+    INSTRUMENTAR(cargar_en_bloque);
+    hacer_propio();                            // O(n + m + Σ c) la primera vez después de abrir una instantánea
+    for (const auto& [alias, id] : nuevos_usuarios) { // O(n) iteraciones
+        registrar_usuario(alias, id);          // O(log n) + O(1) promedio
+    }
+
+    // Pasar las amistades a slots y reservar lugar en cada lista de una sola vez
+    vector<pair<int, int>> aristas;
+    aristas.reserve(nuevas_amistades.size());
+    vector<int> agregados(amigos.size(), 0);
+    for (const auto& [id_A, id_B] : nuevas_amistades) { // O(m) iteraciones
+        int a = slot_de(id_A), b = slot_de(id_B); // O(1) promedio
+        if (a == b) continue;                  // nadie es amigo de sí mismo
+        aristas.emplace_back(a, b);
+        agregados[a]++;
+        agregados[b]++;
+    }
+    for (int s = 0; s < (int)amigos.size(); s++) { // O(n)
+        amigos[s].reserve(amigos[s].size() + agregados[s]);
+    }
+
+    // Volcar ambas direcciones, y ordenar y deduplicar sólo las listas tocadas
+    for (const auto& [a, b] : aristas) {       // O(m)
+        amigos[a].push_back(b);
+        amigos[b].push_back(a);
+    }
+    for (int s = 0; s < (int)amigos.size(); s++) { // O(n + m log m)
+        if (agregados[s] == 0) continue;
+        sort(amigos[s].begin(), amigos[s].end());
+        amigos[s].erase(unique(amigos[s].begin(), amigos[s].end()), amigos[s].end());
+    }
+
+    reconstruir_todo();                        // O(n log n + Σ grado^2 log grado), en paralelo; arma los índices
+
+    // Los usuarios ya se anotaron al registrarlos
+    for (const auto& [id_A, id_B] : nuevas_amistades) { // O(m)
+        if (id_A != id_B) anotar(Bitacora::alta_amistad, id_A, id_B);
+    }
+}
+// Complejidad: O(n log n + m log m + Σ grado^2 log grado) donde n es la cantidad de usuarios
+// y m la de amistades
+
+void RedSocial::cargar_desde_archivo(const string & ruta){
+    ifstream archivo(ruta);
+    if (!archivo) {
+        throw runtime_error("no se pudo abrir " + ruta);
+    }
+
+    // Formato: una línea por registro, "usuario <id> <alias>" o "amistad <id_A> <id_B>";
+    // las líneas vacías y las que empiezan con '#' se ignoran
+    vector<pair<string, int>> nuevos_usuarios;
+    vector<pair<int, int>> nuevas_amistades;
+    string linea;
+    int numero = 0;
+    while (getline(archivo, linea)) {          // O(tamaño del archivo)
+        numero++;
+        if (linea.empty() || linea[0] == '#') continue;
+        istringstream campos(linea);
+        string tipo;
+        campos >> tipo;
+        if (tipo == "usuario") {
+            int id;
+            string alias;
+            if (campos >> id >> alias) {
+                nuevos_usuarios.emplace_back(alias, id);
+                continue;
+            }
+        } else if (tipo == "amistad") {
+            int id_A, id_B;
+            if (campos >> id_A >> id_B) {
+                nuevas_amistades.emplace_back(id_A, id_B);
+                continue;
+            }
+        }
+        throw runtime_error(ruta + ":" + to_string(numero) + ": línea inválida");
+    }
+
+    cargar_en_bloque(nuevos_usuarios, nuevas_amistades);
+}
+// Complejidad: la de leer el archivo más la de cargar_en_bloque
+
+void RedSocial::fijar_modo_conocidos(int id, ModoConocidos modo){
+    int slot = slot_de(id);                    // O(1) promedio
+    bool ansioso = modo == ModoConocidos::ansioso;
+    if (conocidos_ansiosos[slot] == ansioso) return;
+
+    conocidos_ansiosos[slot] = ansioso;
+    if (ansioso) {
+        conocidos_al_dia_de(slot);             // O(grado^2 log grado) si no estaba al día
+    }
+}
+// Complejidad: O(1) promedio al pasar a perezoso (conserva lo calculado hasta el próximo cambio),
+// O(grado^2 log grado) al pasar a ansioso si sus conocidos no estaban al día
+
+
+void RedSocial::guardar_instantanea(const string & ruta, bool con_conocidos) const{
+    INSTRUMENTAR(guardar_instantanea);
+    const int n = id_de_slot.size();
+
+    // Banderas por slot: sólo se guardan los conocidos que ya están calculados, ya sea en
+    // memoria o en la instantánea abierta; los demás se calcularán al volver a abrirla
+    vector<uint8_t> banderas(n, 0);
+    CabeceraInstantanea cabecera{};
+    for (int s = 0; s < n; s++) {              // O(n)
+        if (conocidos_ansiosos[s]) banderas[s] |= slot_ansioso;
+        if (id_de_slot[s] == -1) continue;
+        cabecera.cantidad_ocupados++;
+        cabecera.cantidad_amigos += amigos_de(s).size();
+        cabecera.bytes_alias += alias_de(s).size();
+        if (!con_conocidos) continue;
+        if (conocidos_al_dia[s]) {
+            banderas[s] |= conocidos_guardados;
+            cabecera.cantidad_conocidos += conocidos[s].size();
+        } else if (respaldo && respaldo->tiene_conocidos(s)) {
+            banderas[s] |= conocidos_guardados;
+            cabecera.cantidad_conocidos += respaldo->conocidos(s).size();
+        }
+    }
+    memcpy(cabecera.magia, Instantanea::magia, sizeof(cabecera.magia));
+    cabecera.version = Instantanea::version_actual;
+    cabecera.orden_bytes = Instantanea::marca_orden_bytes;
+    cabecera.cantidad_slots = n;
+    cabecera.amistades_count = amistades_count;
+    cabecera.grado_maximo = ranking.empty() ? 0 : -ranking.begin()->first;
+    cabecera.slot_mas_popular = slot_mas_popular;
+    cabecera.modo_conocidos = (int32_t)modo_conocidos;
+    cabecera.secuencia_bitacora = secuencia;
+    Instantanea::ubicar_secciones(cabecera);   // O(1)
+
+    // Se escribe a un archivo temporal y se lo renombra al final, así una instantánea a
+    // medio escribir nunca reemplaza a la anterior
+    string temporal = ruta + ".tmp";
+    ofstream archivo(temporal, ios::binary | ios::trunc);
+    if (!archivo) {
+        throw runtime_error("no se pudo crear " + temporal);
+    }
+    auto escribir = [&](const void * datos, size_t bytes) {
+        archivo.write(static_cast<const char *>(datos), bytes);
+    };
+    auto rellenar_hasta = [&](uint64_t posicion) {
+        static const char ceros[8] = {};
+        escribir(ceros, posicion - (uint64_t)archivo.tellp()); // a lo sumo 7 bytes
+    };
+    auto empezar_seccion = [&](SeccionInstantanea seccion) {
+        rellenar_hasta(cabecera.seccion[seccion]);
+    };
+    auto escribir_inicios = [&](auto largo_de) {
+        uint64_t inicio = 0;
+        escribir(&inicio, sizeof(inicio));
+        for (int s = 0; s < n; s++) {
+            inicio += largo_de(s);
+            escribir(&inicio, sizeof(inicio));
+        }
+    };
+    auto largo_conocidos = [&](int s) -> uint64_t {
+        if (!(banderas[s] & conocidos_guardados)) return 0;
+        return conocidos_al_dia[s] ? conocidos[s].size() : respaldo->conocidos(s).size();
+    };
+
+    escribir(&cabecera, sizeof(cabecera));
+
+    empezar_seccion(seccion_ids);
+    escribir(id_de_slot.data(), n * sizeof(int32_t));
+
+    empezar_seccion(seccion_inicios_alias);
+    escribir_inicios([&](int s) { return alias_de(s).size(); });
+    empezar_seccion(seccion_alias);
+    for (int s = 0; s < n; s++) escribir(alias_de(s).data(), alias_de(s).size());
+
+    empezar_seccion(seccion_inicios_amigos);
+    escribir_inicios([&](int s) { return amigos_de(s).size(); });
+    empezar_seccion(seccion_amigos);
+    for (int s = 0; s < n; s++) escribir(amigos_de(s).data(), amigos_de(s).size_bytes());
+
+    empezar_seccion(seccion_inicios_conocidos);
+    escribir_inicios(largo_conocidos);
+    empezar_seccion(seccion_conocidos);
+    vector<ConocidoGuardado> de_un_slot;
+    for (int s = 0; s < n; s++) {              // O(Σ c log c)
+        if (largo_conocidos(s) == 0) continue;
+        if (conocidos_al_dia[s]) {
+            de_un_slot.clear();
+            for (const auto& [v, en_comun] : conocidos[s]) de_un_slot.push_back({v, en_comun});
+            sort(de_un_slot.begin(), de_un_slot.end(),
+                 [](ConocidoGuardado x, ConocidoGuardado y) { return x.slot < y.slot; });
+            escribir(de_un_slot.data(), de_un_slot.size() * sizeof(ConocidoGuardado));
+        } else {
+            span<const ConocidoGuardado> guardados = respaldo->conocidos(s);
+            escribir(guardados.data(), guardados.size_bytes());
+        }
+    }
+
+    empezar_seccion(seccion_banderas);
+    escribir(banderas.data(), banderas.size());
+
+    empezar_seccion(seccion_orden_por_grado);
+    for (auto [menos_grado, id] : ranking) {   // O(n), en el orden del ranking
+        int32_t s = slot_de_id.at(id);
+        escribir(&s, sizeof(s));
+    }
+    rellenar_hasta(cabecera.tamanio_archivo);
+
+    archivo.close();
+
+    // Sincronizar antes de renombrar: un punto de control vacía la bitácora confiando en que
+    // la instantánea ya está en disco
+    int fd = open(temporal.c_str(), O_RDONLY);
+    bool sincronizado = fd != -1 && fsync(fd) == 0;
+    if (fd != -1) close(fd);
+    if (!archivo || !sincronizado || rename(temporal.c_str(), ruta.c_str()) != 0) {
+        remove(temporal.c_str());
+        throw runtime_error("no se pudo escribir " + ruta);
+    }
+}
+// Complejidad: O(n + m + Σ c log c) donde m es la cantidad de amistades y c la de conocidos
+
+void RedSocial::abrir_instantanea(const string & ruta){
+    INSTRUMENTAR(abrir_instantanea);
+    auto instantanea = make_shared<const Instantanea>(ruta); // lanza runtime_error si es inválida
+    const CabeceraInstantanea & cabecera = instantanea->cabecera();
+    const int n = instantanea->cantidad_slots();
+
+    reiniciar(n);                              // O(n)
+    slot_de_id.reserve(cabecera.cantidad_ocupados);
+    slots_por_alias.reserve(cabecera.cantidad_ocupados);
+
+    modo_conocidos = (ModoConocidos)cabecera.modo_conocidos;
+    for (int s = n - 1; s >= 0; s--) {         // O(n log n), al revés para reusar primero los slots bajos
+        conocidos_ansiosos[s] = instantanea->ansioso(s);
+        int id = instantanea->id_de_slot(s);
+        if (id == -1) {
+            slots_libres.push_back(s);
+            continue;
+        }
+        id_de_slot[s] = id;
+        alias_de_slot[s] = arena_de_alias.guardar(instantanea->alias_de_slot(s)); // O(|alias|) amortizado
+        slot_de_id[id] = s;                    // O(1) promedio
+        slots_por_alias.insert(s);             // O(|alias|) promedio
+        ids.insert(id);                        // O(log n)
+        conocidos_al_dia[s] = false;           // se copian o calculan al consultarlos
+    }
+
+    // Se guardaron en el orden del ranking, así que cada inserción va al final
+    for (int s : instantanea->orden_por_grado()) { // O(n log n)
+        poner_en_grado(s, instantanea->amigos(s).size());
+    }
+    amistades_count = cabecera.amistades_count;
+    recalcular_mas_popular();                  // O(1) promedio
+    secuencia = cabecera.secuencia_bitacora;
+    triangulos_al_dia = false;                 // se cuentan en la primera consulta
+    componentes_al_dia = false;
+
+    respaldo = instantanea;
+}
+// Complejidad: O(n log n + bytes de alias); amigos y conocidos se leen del archivo al usarlos
+
+void RedSocial::activar_bitacora(const string & ruta, int registros_por_grupo){
+    bitacora.reset();                          // confirma la anterior, si había
+    bitacora = make_unique<Bitacora>(ruta, registros_por_grupo);
+}
+// Complejidad: O(tamaño del archivo), para recortar un posible registro roto al final
+
+void RedSocial::confirmar_bitacora(){
+    if (bitacora) bitacora->confirmar();
+}
+// Complejidad: O(registros pendientes) más un fdatasync
+
+void RedSocial::desactivar_bitacora(){
+    bitacora.reset();                          // el destructor confirma lo pendiente
+}
+// Complejidad: O(registros pendientes) más un fdatasync
+
+void RedSocial::punto_de_control(const string & ruta_instantanea){
+    guardar_instantanea(ruta_instantanea);
+    // Si el proceso se cae antes de vaciarla, recuperar saltea los registros que la
+    // instantánea ya incluye
+    if (bitacora) bitacora->vaciar();
+}
+// Complejidad: la de guardar_instantanea
+
+int RedSocial::recuperar(const string & ruta_instantanea, const string & ruta_bitacora){
+    INSTRUMENTAR(recuperar);
+    vector<Bitacora::Registro> registros = Bitacora::leer(ruta_bitacora); // O(tamaño del archivo)
+    if (ifstream(ruta_instantanea)) {
+        abrir_instantanea(ruta_instantanea);  // O(n log n)
+    } else {
+        reiniciar(0);
+    }
+
+    // Lo que se reaplica ya está en la bitácora: no se vuelve a anotar
+    unique_ptr<Bitacora> activa = std::move(bitacora);
+
+    // Entre dos bajas de usuario, los usuarios nuevos se registran a medida que aparecen y de
+    // cada par sólo importa su último registro de amistad; esos cambios netos se aplican
+    // juntos, con una sola actualización de conocidos y del más popular
+    unordered_map<uint64_t, bool> quedan_amigos; // clave_de_par -> estado final del par
+    auto aplicar_tanda = [&]() {
+        hacer_propio();                        // O(n + m + Σ c) la primera vez
+        vector<pair<int, int>> altas, bajas;
+        cambios_netos(quedan_amigos, altas, bajas); // O(p log grado), p = pares tocados
+        quedan_amigos.clear();
+        aplicar_cambios_de_amistad(altas, bajas);
+    };
+
+    int aplicados = 0;
+    for (const Bitacora::Registro & r : registros) { // O(r) iteraciones
+        if (r.secuencia <= secuencia) continue; // ya estaba en la instantánea
+        switch (r.tipo) {
+            case Bitacora::registro_usuario:
+                registrar_usuario(r.alias, r.id_A); // O(log n)
+                break;
+            case Bitacora::baja_usuario:
+                aplicar_tanda();               // la tanda puede involucrar al usuario
+                eliminar_usuario(r.id_A);
+                break;
+            case Bitacora::alta_amistad:
+            case Bitacora::baja_amistad:
+                quedan_amigos[clave_de_par(slot_de(r.id_A), slot_de(r.id_B))] = r.tipo == Bitacora::alta_amistad;
+                break;
+        }
+        secuencia = r.secuencia;
+        aplicados++;
+    }
+    aplicar_tanda();
+
+    bitacora = std::move(activa);
+    return aplicados;
+}
+// Complejidad: O(tamaño de la bitácora) más abrir la instantánea, más cada tanda en
+// aplicar_cambios_de_amistad y cada baja de usuario en eliminar_usuario
+
+void RedSocial::publicar(){
+    INSTRUMENTAR(publicar);
+    using Bloque = VersionRedSocial::Bloque;
+    const int por_bloque = VersionRedSocial::usuarios_por_bloque;
+    shared_ptr<const VersionRedSocial> anterior = publicada.load();
+    auto nueva = make_shared<VersionRedSocial>();
+    const int n = id_de_slot.size();
+    const int cantidad_bloques = (n + por_bloque - 1) / por_bloque;
+
+    // Se parte de los bloques de la versión anterior y se copian sólo los que tienen
+    // algún slot modificado; la primera vez (o tras reemplazar todo) se marcan todos
+    if (!anterior || publicar_todo) {
+        por_publicar.clear();
+        for (int s = 0; s < n; s++) por_publicar.push_back(s); // O(n)
+    } else {
+        nueva->bloques = anterior->bloques;    // O(n / bloque)
+    }
+    nueva->bloques.resize(cantidad_bloques);
+    vector<shared_ptr<Bloque>> copiados(cantidad_bloques);
+    for (int s : por_publicar) {               // O(u) iteraciones, u = usuarios modificados
+        int b = s / por_bloque;
+        if (!copiados[b]) {
+            copiados[b] = nueva->bloques[b] ? make_shared<Bloque>(*nueva->bloques[b]) // O(bloque)
+                                            : make_shared<Bloque>();
+            nueva->bloques[b] = copiados[b];
+        }
+        shared_ptr<const VersionRedSocial::Usuario> usuario;
+        if (id_de_slot[s] != -1) {
+            // Las vistas de la API pública son justamente lo que se publica
+            usuario = make_shared<VersionRedSocial::Usuario>(VersionRedSocial::Usuario{
+                string(alias_de(s)),
+                materializar(vista_amigos[s], amigos_de(s)),                  // O(k log k)
+                materializar(vista_conocidos[s], conocidos_al_dia_de(s))});   // O(c log c)
+        }
+        (*copiados[b])[s % por_bloque] = usuario;
+        CONTAR(usuarios_publicados, 1);
+    }
+
+    // Los índices por id y por alias se comparten mientras no cambie el conjunto de usuarios
+    if (!anterior || usuarios_cambiaron) {
+        nueva->ids = make_shared<const set<int>>(ids);             // O(n)
+        nueva->slot_de_id = make_shared<const unordered_map<int, int>>(slot_de_id);
+        auto alias_to_id = make_shared<MapaPorAlias<string, int>>(); // O(n), con copia de cada alias
+        alias_to_id->reserve(slots_por_alias.size());
+        for (int s : slots_por_alias) alias_to_id->emplace(alias_de(s), id_de_slot[s]);
+        nueva->alias_to_id = std::move(alias_to_id);
+    } else {
+        nueva->ids = anterior->ids;
+        nueva->slot_de_id = anterior->slot_de_id;
+        nueva->alias_to_id = anterior->alias_to_id;
+    }
+    nueva->amistades_count = amistades_count;
+    nueva->slot_mas_popular = slot_mas_popular;
+    nueva->secuencia_publicada = secuencia;
+
+    publicada.store(std::move(nueva));        // los lectores ven la versión nueva desde acá
+    for (int s : por_publicar) {
+        if (s < (int)marcado_para_publicar.size()) marcado_para_publicar[s] = false;
+    }
+    por_publicar.clear();
+    publicando = true;
+    publicar_todo = false;
+    usuarios_cambiaron = false;
+}
+// Complejidad: O(n / bloque + Σ (k log k + c log c)) sobre los u usuarios modificados, más
+// O(u * bloque) de copiar bloques; si cambió el conjunto de usuarios, además O(n)
+
+shared_ptr<const VersionRedSocial> RedSocial::version() const{
+    return publicada.load();                   // O(1), no espera al escritor
+}
+// Complejidad: O(1)
+
+string RedSocial::reporte(FormatoReporte formato) const{
+    long long conocidos_guardados = 0, al_dia = 0, hubs = 0, vistas_vigentes = 0;
+    for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n)
+        if (id_de_slot[s] == -1) continue;
+        conocidos_guardados += conocidos[s].size();
+        al_dia += conocidos_al_dia[s];
+        hubs += indice_de_amigos[s] != nullptr;
+        vistas_vigentes += vista_amigos[s].vigente + vista_conocidos[s].vigente;
+    }
+    vector<pair<string, long long>> tamanios = {
+        {"usuarios", (long long)ids.size()},
+        {"amistades", amistades_count},
+        {"slots", (long long)id_de_slot.size()},
+        {"slots_libres", (long long)slots_libres.size()},
+        {"conocidos_guardados", conocidos_guardados},
+        {"usuarios_con_conocidos_al_dia", al_dia},
+        {"hubs", hubs},
+        {"vistas_vigentes", vistas_vigentes},
+        {"pendientes_de_publicar", (long long)por_publicar.size()},
+    };
+    UsoDeMemoria memoria = uso_de_memoria();   // O(n + Σ |vistas materializadas|)
+    for (const auto& [estructura, bytes] : memoria.por_estructura) {
+        tamanios.emplace_back("bytes_" + estructura, (long long)bytes);
+    }
+    tamanios.emplace_back("bytes_total", (long long)memoria.total);
+    tamanios.emplace_back("bytes_por_usuario", llround(memoria.bytes_por_usuario));
+    tamanios.emplace_back("bytes_por_amistad", llround(memoria.bytes_por_amistad));
+#ifdef REDSOCIAL_INSTRUMENTACION
+    return Instrumentacion::reporte(formato, &medidas, tamanios);
+#else
+    return Instrumentacion::reporte(formato, nullptr, tamanios); // sin mediciones, sólo los tamaños
+#endif
+}
+// Complejidad: O(n + Σ |vistas materializadas| + operaciones * cubetas)
+
+// Lo que piden los contenedores de libstdc++ para n elementos de tipo T: un nodo de
+// árbol lleva color y tres punteros, y uno de tabla de hash el puntero al siguiente
+// (ninguna de estas tablas guarda el hash de cada elemento)
+template <class T>
+static size_t bytes_de_nodos_de_arbol(size_t n){
+    return n * (sizeof(void *) * 4 + (sizeof(T) + alignof(void *) - 1) / alignof(void *) * alignof(void *));
+}
+// Complejidad: O(1)
+
+template <class Tabla>
+static size_t bytes_de_tabla(const Tabla & tabla){
+    using T = typename Tabla::value_type;
+    size_t nodo = sizeof(void *) + (sizeof(T) + alignof(void *) - 1) / alignof(void *) * alignof(void *);
+    return tabla.bucket_count() * sizeof(void *) + tabla.size() * nodo;
+}
+// Complejidad: O(1)
+
+template <class Vector>
+static size_t bytes_de_vector(const Vector & v){
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+// Complejidad: O(1)
+
+RedSocial::UsoDeMemoria RedSocial::uso_de_memoria() const{
+    size_t bytes_amigos = bytes_de_vector(amigos), bytes_indices = bytes_de_vector(indice_de_amigos);
+    size_t bytes_conocidos = bytes_de_vector(conocidos) + bytes_de_vector(conocidos_ansiosos) +
+                             bytes_de_vector(conocidos_al_dia);
+    size_t bytes_vistas = bytes_de_vector(vista_amigos) + bytes_de_vector(vista_conocidos);
+    const size_t sin_reservar = string().capacity(); // lo que entra dentro del string
+    auto sumar_vista = [&](const Vista & vista) {
+        bytes_vistas += bytes_de_nodos_de_arbol<string>(vista.alias.size());
+        for (const string & alias : vista.alias) { // O(|vista|)
+            if (alias.capacity() > sin_reservar) bytes_vistas += alias.capacity() + 1;
+        }
+    };
+    for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n)
+        bytes_amigos += bytes_de_vector(amigos[s]);
+        if (indice_de_amigos[s]) bytes_indices += sizeof(MapaDeBits) + indice_de_amigos[s]->bytes();
+        bytes_conocidos += bytes_de_tabla(conocidos[s]);
+        sumar_vista(vista_amigos[s]);
+        sumar_vista(vista_conocidos[s]);
+    }
+
+    size_t bytes_componentes = bytes_de_vector(componente_de_slot) + bytes_de_vector(posicion_en_componente) +
+                               bytes_de_vector(miembros_de_componente) + bytes_de_vector(componentes_libres);
+    for (const vector<int> & miembros : miembros_de_componente) {
+        bytes_componentes += bytes_de_vector(miembros); // O(componentes), a lo sumo n
+    }
+
+    UsoDeMemoria uso;
+    uso.por_estructura = {
+        {"ids", bytes_de_nodos_de_arbol<int>(ids.size())},
+        {"slot_de_id", bytes_de_tabla(slot_de_id)},
+        {"id_de_slot", bytes_de_vector(id_de_slot) + bytes_de_vector(slots_libres)},
+        {"alias", arena_de_alias.bytes_reservados() + bytes_de_vector(alias_de_slot)},
+        {"slots_por_alias", bytes_de_tabla(slots_por_alias)},
+        {"amigos", bytes_amigos},
+        {"indices_de_hubs", bytes_indices},
+        {"conocidos", bytes_conocidos},
+        // El ranking guarda además el tamaño de cada subárbol
+        {"ranking", bytes_de_nodos_de_arbol<pair<pair<int, int>, size_t>>(ranking.size())},
+        {"triangulos", bytes_de_vector(triangulos_de_slot)},
+        {"componentes", bytes_componentes},
+        {"vistas", bytes_vistas},
+        {"recorridos", bytes_de_vector(epoca_de_slot) + bytes_de_vector(nivel_de_slot)},
+        {"publicacion", bytes_de_vector(por_publicar) + bytes_de_vector(marcado_para_publicar)},
+    };
+    for (const auto& [estructura, bytes] : uso.por_estructura) uso.total += bytes;
+    if (!ids.empty()) uso.bytes_por_usuario = (double)uso.total / ids.size();
+    if (amistades_count > 0) uso.bytes_por_amistad = (double)uso.total / amistades_count;
+    return uso;
+}
+// Complejidad: O(n + Σ |vistas materializadas|)
+
+#ifdef REDSOCIAL_INSTRUMENTACION
+const Instrumentacion & RedSocial::instrumentacion() const{
+    return medidas;
+}
+// Complejidad: O(1)
+
+void RedSocial::reiniciar_instrumentacion(){
+    medidas.reiniciar();
+}
+// Complejidad: O(operaciones * cubetas)
+#endif
 
 
 
 // Funciones auxiliares
 
-void RedSocial::reconstruir_conocidos_de(int id) {
-    const string alias_u = users[id];          // O(log n), búsqueda en map
-    auto& out = conocidos[id];                 // O(log n), búsqueda en map
-    out.clear();                               // O(|conocidos[id]|), limpiar set
-    
+int RedSocial::slot_de(int id) const {
+    return slot_de_id.at(id);                  // O(1) promedio, búsqueda en unordered_map
+}
+// Complejidad: O(1) promedio; lanza out_of_range si el id no está registrado
+
+string_view RedSocial::alias_de(int slot) const {
+    return arena_de_alias.ver(alias_de_slot[slot]); // O(1)
+}
+// Complejidad: O(1); vacío si el slot está libre
+
+uint32_t RedSocial::nueva_epoca() const {
+    // Los slots nuevos empiezan sin visitar; al dar la vuelta el contador se limpia todo
+    epoca_de_slot.resize(id_de_slot.size(), 0); // O(1) amortizado
+    nivel_de_slot.resize(id_de_slot.size(), 0);
+    if (++epoca_actual == 0) {
+        fill(epoca_de_slot.begin(), epoca_de_slot.end(), 0); // O(n), una vez cada 2^32 consultas
+        epoca_actual = 1;
+    }
+    return epoca_actual;
+}
+// Complejidad: O(1) amortizado
+
+int RedSocial::nuevo_slot() {
+    if (!slots_libres.empty()) {
+        int slot = slots_libres.back();        // O(1)
+        slots_libres.pop_back();               // O(1)
+        conocidos_ansiosos[slot] = modo_conocidos == ModoConocidos::ansioso;
+        return slot;
+    }
+    id_de_slot.push_back(-1);                  // O(1) amortizado
+    alias_de_slot.push_back(ArenaDeAlias::ninguno);
+    amigos.emplace_back();
+    conocidos.emplace_back();
+    indice_de_amigos.emplace_back();
+    triangulos_de_slot.push_back(0);
+    componente_de_slot.push_back(-1);
+    posicion_en_componente.push_back(-1);
+    conocidos_ansiosos.push_back(modo_conocidos == ModoConocidos::ansioso);
+    conocidos_al_dia.push_back(true);
+    vista_amigos.emplace_back();
+    vista_conocidos.emplace_back();
+    return (int)id_de_slot.size() - 1;
+}
+// Complejidad: O(1) amortizado
+
+span<const int> RedSocial::amigos_de(int slot) const {
+    if (respaldo) {
+        return respaldo->amigos(slot);         // O(1), directo del archivo mapeado
+    }
+    return amigos[slot];
+}
+// Complejidad: O(1)
+
+bool RedSocial::es_amigo(int a, int b) const {
+    if (indice_de_amigos[a]) {
+        return indice_de_amigos[a]->contiene(b); // O(1)
+    }
+    return contiene(amigos_de(a), b);          // O(log |amigos[a]|), búsqueda binaria
+}
+// Complejidad: O(1) si a es un hub, sino O(log |amigos[a]|)
+
+int RedSocial::contar_en_comun(int a, int b) const {
+    const MapaDeBits * indice_a = indice_de_amigos[a].get();
+    const MapaDeBits * indice_b = indice_de_amigos[b].get();
+    if (indice_a && indice_b) {
+        return indice_a->contar_interseccion(*indice_b); // grupo por grupo, con popcount
+    }
+    if (indice_a || indice_b) {
+        // Uno solo es hub: se busca cada amigo del otro en su índice
+        if (indice_a) swap(a, b);
+        int en_comun = 0;
+        for (int s : amigos_de(a)) {           // O(|amigos[a]|)
+            en_comun += indice_de_amigos[b]->contiene(s);
+        }
+        return en_comun;
+    }
+    return contar_interseccion(amigos_de(a), amigos_de(b)); // O(k_A + k_B), vectorizado o galopando
+}
+// Complejidad: entre dos hubs, la de MapaDeBits::contar_interseccion; con un solo hub, O(k) del
+// otro; si no, la de contar_interseccion (ver Interseccion.h)
+
+void RedSocial::agregar_amigo(int a, int b) {
+    if (!insertar_ordenado(amigos[a], b)) return; // O(|amigos[a]|)
+    int agregado[] = {b};
+    actualizar_indice(a, agregado, {});        // O(1), u O(|amigos[a]|) si recién pasa a ser un hub
+}
+// Complejidad: O(|amigos[a]|)
+
+void RedSocial::quitar_amigo(int a, int b) {
+    if (!borrar_ordenado(amigos[a], b)) return; // O(|amigos[a]|)
+    int quitado[] = {b};
+    actualizar_indice(a, {}, quitado);         // O(1)
+}
+// Complejidad: O(|amigos[a]|)
+
+void RedSocial::actualizar_indice(int slot, span<const int> agregados, span<const int> quitados) {
+    // amigos[slot] ya tiene los cambios; el índice, si existe, todavía no
+    auto& indice = indice_de_amigos[slot];
+    int grado = amigos[slot].size();
+    if (grado < grado_de_hub / 2) {
+        indice.reset();                        // dejó de ser un hub
+        return;
+    }
+    if (!indice) {
+        if (grado < grado_de_hub) return;
+        indice = make_unique<MapaDeBits>();    // recién pasa a ser un hub: se arma con la lista
+        for (int s : amigos[slot]) indice->insertar(s); // O(grado)
+        return;
+    }
+    for (int s : quitados) indice->borrar(s);  // O(|quitados|)
+    for (int s : agregados) indice->insertar(s); // O(|agregados|)
+}
+// Complejidad: O(|agregados| + |quitados|) si ya tenía índice, O(grado) si se arma
+
+void RedSocial::hacer_propio() {
+    if (!respaldo) return;
+
+    // Copiar las listas de amigos y todos los conocidos guardados; los ansiosos que no se
+    // guardaron se calculan, ya con las listas propias
+    for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n + m + Σ c)
+        if (id_de_slot[s] == -1) continue;
+        span<const int> guardados = respaldo->amigos(s);
+        amigos[s].assign(guardados.begin(), guardados.end());
+        actualizar_indice(s, {}, {});          // O(|amigos[s]|) si es un hub
+        if (!conocidos_al_dia[s] && respaldo->tiene_conocidos(s)) {
+            conocidos_al_dia_de(s);
+        }
+    }
+    respaldo.reset();                          // libera el mapeo si nadie más lo usa
+    for (int s = 0; s < (int)id_de_slot.size(); s++) {
+        if (conocidos_ansiosos[s] && !conocidos_al_dia[s]) {
+            reconstruir_conocidos_de(s);       // O(grado^2 log grado)
+        }
+    }
+}
+// Complejidad: O(1) sin respaldo; si no, O(n + m + Σ c) más el cálculo de los conocidos ansiosos
+// que no se guardaron
+
+void RedSocial::reiniciar(int cantidad_slots) {
+    // Vaciar todo y dimensionar las estructuras por slot; los slots quedan libres pero
+    // fuera de slots_libres, quien llama decide cuáles se ocupan
+    const int n = cantidad_slots;
+    respaldo.reset();
+    ids.clear();
+    slots_por_alias.clear();
+    arena_de_alias.vaciar();
+    slot_de_id.clear();
+    slots_libres.clear();
+    ranking.clear();
+    amistades_count = 0;
+    slot_mas_popular = -1;
+    id_mas_popular = -1;
+    secuencia = 0;
+    id_de_slot.assign(n, -1);
+    alias_de_slot.assign(n, ArenaDeAlias::ninguno);
+    amigos.assign(n, ListaDeAmigos());        // cada copia toma el recurso de amigos
+    conocidos.assign(n, Conocidos());
+    indice_de_amigos.clear();
+    indice_de_amigos.resize(n);
+    triangulos_de_slot.assign(n, 0);
+    triangulos_count = 0;
+    triangulos_al_dia = true;
+    componente_de_slot.assign(n, -1);
+    posicion_en_componente.assign(n, -1);
+    miembros_de_componente.clear();
+    componentes_libres.clear();
+    componentes_count = 0;
+    componentes_al_dia = true;
+    conocidos_ansiosos.assign(n, false);
+    conocidos_al_dia.assign(n, true);
+    vista_amigos.assign(n, Vista());
+    vista_conocidos.assign(n, Vista());
+    publicar_todo = true;                      // la próxima versión se arma desde cero
+    usuarios_cambiaron = true;
+    por_publicar.clear();
+    marcado_para_publicar.assign(n, false);
+}
+// Complejidad: O(n + m + Σ c) para liberar lo anterior
+
+void RedSocial::anotar(Bitacora::Tipo tipo, int id_A, int id_B, string_view alias) {
+    secuencia++;
+    if (bitacora) {
+        bitacora->agregar({secuencia, tipo, id_A, id_B, string(alias)}); // confirma si se completó un grupo
+    }
+}
+// Complejidad: O(|alias|) amortizado, más un fdatasync por grupo
+
+void RedSocial::cambios_netos(const unordered_map<uint64_t, bool> & quedan_amigos,
+                              vector<pair<int, int>> & altas, vector<pair<int, int>> & bajas) const {
+    // Sólo cambian los pares de slots cuyo estado final no es el actual
+    for (auto [clave, amigos_al_final] : quedan_amigos) { // O(p) iteraciones
+        int a = clave >> 32, b = (uint32_t)clave;
+        if (amigos_al_final != es_amigo(a, b)) { // O(1) con índice, sino O(log grado)
+            (amigos_al_final ? altas : bajas).emplace_back(a, b);
+        }
+    }
+}
+// Complejidad: O(p log grado), p = cantidad de pares
+
+void RedSocial::aplicar_cambios_de_amistad(const vector<pair<int, int>> & altas,
+                                           const vector<pair<int, int>> & bajas) {
+    INSTRUMENTAR(aplicar_cambios_de_amistad);
+    // Precondición: sin respaldo, sin pares repetidos, los pares de altas no son amigos y
+    // los de bajas sí.
+    // Cada par (u, v) pierde un amigo en común por cada camino u - w - v que desaparece y
+    // gana uno por cada camino que aparece. Un camino cuyas dos amistades cambian en el
+    // mismo sentido se cuenta sólo desde la de menor clave
+    unordered_set<uint64_t> claves_altas, claves_bajas;
+    for (auto [a, b] : altas) claves_altas.insert(clave_de_par(a, b));
+    for (auto [a, b] : bajas) claves_bajas.insert(clave_de_par(a, b));
+    unordered_map<uint64_t, int> cambio_en_comun; // clave_de_par -> cambio de amigos en común
+    auto contar_caminos = [&](const vector<pair<int, int>> & pares, const unordered_set<uint64_t> & claves,
+                              int signo) {
+        for (auto [a, b] : pares) {
+            uint64_t propia = clave_de_par(a, b);
+            for (auto [x, y] : {pair(a, b), pair(b, a)}) { // caminos y - x - w
+                for (int w : amigos[x]) {      // O(|amigos[x]|) iteraciones
+                    uint64_t otra = clave_de_par(x, w);
+                    if (w == y || (otra < propia && claves.count(otra))) continue;
+                    cambio_en_comun[clave_de_par(y, w)] += signo; // O(1) promedio
+                }
+            }
+        }
+    };
+    // Los triángulos que tienen alguna amistad cambiada desaparecen (con las listas de antes)
+    // o aparecen (con las nuevas); uno con varias amistades cambiadas en el mismo sentido se
+    // cuenta sólo desde la de menor clave, y ninguno puede tener una alta y una baja
+    vector<int> comunes;
+    auto sumar_triangulos = [&](const vector<pair<int, int>> & pares, const unordered_set<uint64_t> & claves,
+                                int signo) {
+        if (!triangulos_al_dia) return;
+        for (auto [a, b] : pares) {
+            uint64_t propia = clave_de_par(a, b);
+            comunes.clear();
+            intersectar(amigos[a], amigos[b], comunes); // O(|amigos[a]| + |amigos[b]|) o menos
+            for (int w : comunes) {
+                uint64_t con_a = clave_de_par(a, w), con_b = clave_de_par(b, w);
+                if ((con_a < propia && claves.count(con_a)) || (con_b < propia && claves.count(con_b))) continue;
+                triangulos_de_slot[a] += signo;
+                triangulos_de_slot[b] += signo;
+                triangulos_de_slot[w] += signo;
+                triangulos_count += signo;
+            }
+        }
+    };
+    contar_caminos(bajas, claves_bajas, -1);   // con las listas de antes
+    sumar_triangulos(bajas, claves_bajas, -1);
+
+    // Cada lista tocada se rearma con una sola mezcla: (amigos[s] \ quitar) ∪ agregar
+    unordered_map<int, pair<vector<int>, vector<int>>> cambios_de; // slot -> (agregar, quitar)
+    for (auto [a, b] : altas) {
+        cambios_de[a].first.push_back(b);
+        cambios_de[b].first.push_back(a);
+    }
+    for (auto [a, b] : bajas) {
+        cambios_de[a].second.push_back(b);
+        cambios_de[b].second.push_back(a);
+    }
+    vector<int> restantes;
+    for (auto& [s, cambios] : cambios_de) {    // O(Σ |amigos[s]| + k log k) en total
+        auto& [agregar, quitar] = cambios;
+        sort(agregar.begin(), agregar.end());
+        sort(quitar.begin(), quitar.end());
+        int grado_viejo = amigos[s].size();
+        restantes.clear();
+        set_difference(amigos[s].begin(), amigos[s].end(), quitar.begin(), quitar.end(),
+                       back_inserter(restantes));
+        amigos[s].clear();
+        merge(restantes.begin(), restantes.end(), agregar.begin(), agregar.end(), back_inserter(amigos[s]));
+        actualizar_indice(s, agregar, quitar); // O(|agregar| + |quitar|) si ya tenía índice
+        mover_de_grado(s, grado_viejo, amigos[s].size()); // O(log n)
+        invalidar_vistas(s);
+    }
+    amistades_count += (int)altas.size() - (int)bajas.size();
+
+    contar_caminos(altas, claves_altas, +1);   // con las listas nuevas
+    sumar_triangulos(altas, claves_altas, +1);
+
+    // Primero se unen las componentes de las altas; después, cada componente en la que hubo
+    // bajas se separa de una sola vez desde todos sus extremos, porque cada pedazo en que
+    // haya quedado partida tiene alguno
+    if (componentes_al_dia) {
+        for (auto [a, b] : altas) unir_componentes(a, b); // O(tamaño de la menor) cada una
+        unordered_map<int, vector<int>> extremos_por_componente;
+        for (auto [a, b] : bajas) {
+            extremos_por_componente[componente_de_slot[a]].push_back(a);
+            extremos_por_componente[componente_de_slot[b]].push_back(b);
+        }
+        for (auto& [componente, extremos] : extremos_por_componente) {
+            separar_componente(extremos);
+        }
+    }
+
+    // Una sola actualización por par de conocidos; los pares que cambiaron de amistad se
+    // resuelven aparte
+    for (auto [clave, cambio] : cambio_en_comun) { // O(|cambio_en_comun| log grado)
+        int u = clave >> 32, v = (uint32_t)clave;
+        if (cambio == 0 || claves_bajas.count(clave) || es_amigo(u, v)) continue;
+        ajustar_conocido(u, v, cambio);        // O(1) promedio
+        ajustar_conocido(v, u, cambio);
+    }
+    for (auto [a, b] : altas) {
+        fijar_conocido(a, b, 0);               // O(1) promedio
+        fijar_conocido(b, a, 0);
+    }
+    for (auto [a, b] : bajas) {
+        int en_comun = 0;
+        if (conocidos_ansiosos[a] || conocidos_ansiosos[b]) {
+            en_comun = contar_en_comun(a, b);  // O(|amigos[a]| + |amigos[b]|) o menos
+        }
+        fijar_conocido(a, b, en_comun);        // O(1) promedio
+        fijar_conocido(b, a, en_comun);
+    }
+
+    recalcular_mas_popular();                  // O(1), una sola vez para toda la tanda
+}
+// Complejidad: O(Σ (|amigos[a]| + |amigos[b]|) + k log k) sobre los k pares cambiados (a, b),
+// contra O(k * grado) de corrimientos si se aplicaran de a uno
+
+void RedSocial::reconstruir_conocidos_de(int slot) const {
+    INSTRUMENTAR(reconstruir_conocidos_de);
+    CONTAR(conocidos_reconstruidos, 1);
+    auto& out = conocidos[slot];
+    out.clear();                               // O(|conocidos[slot]|)
+
     // Por cada amigo f de u...
-    for (const auto& alias_f : amigos[id]) {   // O(|amigos[id]|) iteraciones
-        int id_f = obtener_id(alias_f);        // O(1), búsqueda en unordered_map
-        // agrego los amigos de f como conocidos de u (si no son amigos directos de u)
-        for (const auto& alias_w : amigos[id_f]) { // O(|amigos[id_f]|)
-            if (alias_w != alias_u && amigos[id].count(alias_w) == 0) { // O(log |amigos[id]|)
-                out.insert(alias_w);           // O(log |conocidos[id]|)
+    span<const int> amigos_u = amigos_de(slot);
+    for (int f : amigos_u) {                   // O(|amigos[slot]|) iteraciones
+        // agrego los amigos de f como conocidos de u (si no son amigos directos de u),
+        // contando a f como un amigo en común más
+        for (int w : amigos_de(f)) {           // O(|amigos[f]|)
+            if (w != slot && !es_amigo(slot, w)) { // O(1) con índice, sino O(log |amigos[slot]|)
+                out[w] += 1;                   // O(1) promedio
+            }
+        }
+    }
+    conocidos_al_dia[slot] = true;             // O(1)
+    vista_conocidos[slot].vigente = false;     // O(1)
+}
+// Complejidad: O(grado^2 * log grado), donde grado es el grado máximo del usuario
+
+void RedSocial::reconstruir_todo(int cantidad_hilos) {
+    INSTRUMENTAR(reconstruir_todo);
+    // Las listas de amigos son la única fuente: si todavía se leen de una instantánea se
+    // copian, y todo lo demás se descarta y se vuelve a calcular desde ellas
+    if (respaldo) {
+        for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n + m)
+            span<const int> guardados = respaldo->amigos(s);
+            amigos[s].assign(guardados.begin(), guardados.end());
+        }
+        respaldo.reset();
+    }
+    for (int s = 0; s < (int)id_de_slot.size(); s++) { // O(n)
+        invalidar_vistas(s);
+    }
+
+    // Cada hilo tiene su propio buffer: primero recorre un tramo contiguo de slots, arma
+    // los índices de sus hubs, desactualiza sus perezosos y anota sus grados y sus tareas
+    // (los ansiosos, con su costo: la cantidad de caminos de largo 2 que salen de él);
+    // después calcula los conocidos de sus tareas, de la más cara a la más barata, y
+    // cuando se le acaban le roba las más caras que queden a los demás. Cada tarea se toma
+    // con un fetch_add sobre la cola de su dueño, así que no hace falta ningún mutex, y
+    // cada slot sólo lo escribe el hilo que lo tomó
+    const int cantidad = id_de_slot.size();
+    int hilos = cantidad_hilos > 0 ? cantidad_hilos : (int)thread::hardware_concurrency();
+    hilos = max(1, min(hilos, cantidad));
+
+    struct alignas(64) Buffer {
+        vector<pair<long long, int>> tareas; // (costo, slot), de la más cara a la más barata
+        vector<pair<int, int>> grados;       // (-|amigos[s]|, id) de los slots del tramo
+        long long extremos = 0;              // Σ |amigos[s]| del tramo
+        atomic<int> siguiente{0};            // próxima tarea sin tomar de esta cola
+    };
+    vector<Buffer> buffers(hilos);
+    barrier colas_listas(hilos);
+
+    auto tomar = [](Buffer & cola) {
+        int i = cola.siguiente.fetch_add(1, memory_order_relaxed); // O(1), sin bloqueo
+        return i < (int)cola.tareas.size() ? cola.tareas[i].second : -1;
+    };
+    auto trabajar = [&](int h) {
+        Buffer & propio = buffers[h];
+        for (int s = (long long)cantidad * h / hilos; s < (long long)cantidad * (h + 1) / hilos; s++) {
+            if (id_de_slot[s] == -1) {
+                indice_de_amigos[s].reset();
+                conocidos[s].clear();
+                conocidos_al_dia[s] = true;
+                continue;
+            }
+            int grado = amigos[s].size();
+            propio.extremos += grado;
+            propio.grados.emplace_back(-grado, id_de_slot[s]);
+            auto& indice = indice_de_amigos[s];
+            if (grado < grado_de_hub / 2) {
+                indice.reset();
+            } else if (indice || grado >= grado_de_hub) {
+                indice = make_unique<MapaDeBits>(); // se rearma desde la lista
+                for (int f : amigos[s]) indice->insertar(f); // O(grado)
+            }
+            if (conocidos_ansiosos[s]) {
+                long long costo = 1;
+                for (int f : amigos[s]) costo += amigos[f].size(); // O(grado)
+                propio.tareas.emplace_back(costo, s);
+            } else {
+                desactualizar_conocidos(s);    // O(|conocidos[s]|)
+            }
+        }
+        sort(propio.tareas.begin(), propio.tareas.end(), greater<>()); // O(t log t)
+
+        // Nadie roba antes de que todas las colas estén armadas, ni lee un índice a medio armar
+        colas_listas.arrive_and_wait();
+
+        if (h == 0) {
+            // Mientras los demás ya calculan conocidos, este hilo junta los grados de todos
+            // los buffers en el ranking, que ningún otro toca
+            long long extremos = 0;
+            ranking.clear();
+            for (const Buffer & buffer : buffers) { // O(n log n)
+                extremos += buffer.extremos;
+                for (auto par : buffer.grados) ranking.insert(par);
+            }
+            amistades_count = extremos / 2;
+        }
+        for (int i = 0; i < hilos; i++) {     // primero la cola propia, después las ajenas
+            Buffer & cola = buffers[(h + i) % hilos];
+            for (int s = tomar(cola); s != -1; s = tomar(cola)) {
+                reconstruir_conocidos_de(s);   // O(grado^2 log grado)
+            }
+        }
+    };
+    vector<thread> trabajadores;
+    for (int h = 1; h < hilos; h++) {
+        trabajadores.emplace_back(trabajar, h);
+    }
+    trabajar(0);                               // el hilo actual también trabaja
+    for (auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+
+    contar_triangulos(hilos);                  // O(m √m), en paralelo
+    contar_componentes(hilos);                 // O((n + m) α(n)), en paralelo
+    recalcular_mas_popular();                  // O(1)
+}
+// Complejidad: O(n log n + m √m + Σ grado^2 log grado) de trabajo total; todo salvo el ranking
+// y el recorrido de las vistas se reparte entre los hilos
+
+void RedSocial::contar_triangulos(int cantidad_hilos) const {
+    INSTRUMENTAR(contar_triangulos);
+    // Cada amistad se orienta hacia el de más amigos (a igualdad, hacia el slot mayor): así
+    // cada triángulo aparece una sola vez, como u -> v, u -> w y v -> w, y ninguna lista
+    // orientada tiene más de O(√m) slots. Las listas orientadas quedan contiguas en un solo
+    // arreglo, en el orden de slots de las originales, para intersecarlas directamente
+    const int n = id_de_slot.size();
+    auto hacia = [&](int u, int v) {
+        size_t grado_u = amigos_de(u).size(), grado_v = amigos_de(v).size();
+        return grado_u < grado_v || (grado_u == grado_v && u < v);
+    };
+    vector<int> desde(n + 1, 0);
+    for (int u = 0; u < n; u++) {              // O(m)
+        for (int v : amigos_de(u)) desde[u + 1] += hacia(u, v);
+    }
+    partial_sum(desde.begin(), desde.end(), desde.begin()); // O(n)
+    vector<int> salientes(desde[n]);
+    for (int u = 0; u < n; u++) {              // O(m)
+        int pos = desde[u];
+        for (int v : amigos_de(u)) {
+            if (hacia(u, v)) salientes[pos++] = v;
+        }
+    }
+    auto salientes_de = [&](int u) {
+        return span<const int>(salientes).subspan(desde[u], desde[u + 1] - desde[u]);
+    };
+
+    // Los hilos toman bloques de slots; un mismo triángulo suma en tres slots que pueden
+    // ser de bloques de otros hilos, así que esas sumas son atómicas
+    triangulos_de_slot.assign(n, 0);
+    auto sumar = [&](int s, long long cantidad) {
+        atomic_ref<long long>(triangulos_de_slot[s]).fetch_add(cantidad, memory_order_relaxed);
+    };
+    const int bloque = 64;
+    atomic<int> siguiente(0);
+    atomic<long long> total(0);
+    auto trabajar = [&]() {
+        vector<int> comunes;
+        long long propios = 0;
+        for (int inicio = siguiente.fetch_add(bloque); inicio < n; inicio = siguiente.fetch_add(bloque)) {
+            for (int u = inicio; u < min(inicio + bloque, n); u++) {
+                for (int v : salientes_de(u)) { // O(Σ min(|salientes u|, |salientes v|)) en total
+                    comunes.clear();
+                    intersectar(salientes_de(u), salientes_de(v), comunes);
+                    if (comunes.empty()) continue;
+                    sumar(u, comunes.size());
+                    sumar(v, comunes.size());
+                    for (int w : comunes) sumar(w, 1);
+                    propios += comunes.size();
+                }
+            }
+        }
+        total.fetch_add(propios, memory_order_relaxed);
+    };
+    int hilos = cantidad_hilos > 0 ? cantidad_hilos : (int)thread::hardware_concurrency();
+    hilos = max(1, min(hilos, n / bloque));
+    vector<thread> trabajadores;
+    for (int h = 1; h < hilos; h++) {
+        trabajadores.emplace_back(trabajar);
+    }
+    trabajar();                                // el hilo actual también trabaja
+    for (auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+    triangulos_count = total;
+    triangulos_al_dia = true;
+}
+// Complejidad: O(m √m) de trabajo total, repartido entre los hilos
+
+void RedSocial::contar_componentes(int cantidad_hilos) const {
+    INSTRUMENTAR(contar_componentes);
+    // Unión de conjuntos sin bloqueos: cada hilo toma bloques de slots y une los extremos
+    // de sus amistades colgando siempre la raíz de slot mayor de la de slot menor, con un
+    // compare_exchange que falla si otro hilo la colgó antes; así nunca se forma un ciclo.
+    // Las búsquedas acortan el camino a medida que suben
+    const int n = id_de_slot.size();
+    vector<atomic<int>> padre(n);
+    for (int s = 0; s < n; s++) padre[s].store(s, memory_order_relaxed); // O(n)
+    auto raiz = [&](int s) {
+        while (true) {
+            int p = padre[s].load();
+            if (p == s) return s;
+            int abuelo = padre[p].load();
+            if (abuelo != p) padre[s].compare_exchange_weak(p, abuelo); // si falla, otro ya lo subió
+            s = abuelo;
+        }
+    };
+    auto unir = [&](int a, int b) {
+        while (true) {
+            a = raiz(a);
+            b = raiz(b);
+            if (a == b) return;
+            if (a < b) swap(a, b);
+            if (padre[a].compare_exchange_strong(a, b)) return; // a seguía siendo raíz
+        }
+    };
+    const int bloque = 64;
+    atomic<int> siguiente(0);
+    auto trabajar = [&]() {
+        for (int inicio = siguiente.fetch_add(bloque); inicio < n; inicio = siguiente.fetch_add(bloque)) {
+            for (int u = inicio; u < min(inicio + bloque, n); u++) {
+                for (int v : amigos_de(u)) {   // O(|amigos[u]|) uniones, casi O(1) cada una
+                    if (u < v) unir(u, v);     // cada amistad desde un solo extremo
+                }
+            }
+        }
+    };
+    int hilos = cantidad_hilos > 0 ? cantidad_hilos : (int)thread::hardware_concurrency();
+    hilos = max(1, min(hilos, n / bloque));
+    vector<thread> trabajadores;
+    for (int h = 1; h < hilos; h++) {
+        trabajadores.emplace_back(trabajar);
+    }
+    trabajar();                                // el hilo actual también trabaja
+    for (auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+
+    // Una componente por raíz, numeradas en el orden de sus slots
+    componente_de_slot.assign(n, -1);
+    posicion_en_componente.assign(n, -1);
+    miembros_de_componente.clear();
+    componentes_libres.clear();
+    vector<int> componente_de_raiz(n, -1);
+    for (int s = 0; s < n; s++) {              // O(n α(n))
+        if (id_de_slot[s] == -1) continue;
+        int& c = componente_de_raiz[raiz(s)];
+        if (c == -1) {
+            c = miembros_de_componente.size();
+            miembros_de_componente.emplace_back();
+        }
+        componente_de_slot[s] = c;
+        posicion_en_componente[s] = miembros_de_componente[c].size();
+        miembros_de_componente[c].push_back(s);
+    }
+    componentes_count = miembros_de_componente.size();
+    componentes_al_dia = true;
+}
+// Complejidad: O((n + m) α(n)) de trabajo total; las uniones se reparten entre los hilos
+
+int RedSocial::nueva_componente() {
+    componentes_count++;
+    if (!componentes_libres.empty()) {
+        int c = componentes_libres.back();     // O(1)
+        componentes_libres.pop_back();
+        return c;
+    }
+    miembros_de_componente.emplace_back();     // O(1) amortizado
+    return (int)miembros_de_componente.size() - 1;
+}
+// Complejidad: O(1) amortizado
+
+void RedSocial::poner_en_componente(int slot, int componente) {
+    componente_de_slot[slot] = componente;
+    posicion_en_componente[slot] = miembros_de_componente[componente].size();
+    miembros_de_componente[componente].push_back(slot); // O(1) amortizado
+}
+// Complejidad: O(1) amortizado
+
+void RedSocial::sacar_de_componente(int slot) {
+    // El último de la lista pasa al lugar del que sale
+    vector<int> & miembros = miembros_de_componente[componente_de_slot[slot]];
+    int posicion = posicion_en_componente[slot];
+    miembros[posicion] = miembros.back();
+    posicion_en_componente[miembros[posicion]] = posicion;
+    miembros.pop_back();
+    if (miembros.empty()) {
+        componentes_libres.push_back(componente_de_slot[slot]); // O(1) amortizado
+        componentes_count--;
+    }
+    componente_de_slot[slot] = -1;
+    posicion_en_componente[slot] = -1;
+}
+// Complejidad: O(1) amortizado
+
+void RedSocial::unir_componentes(int a, int b) {
+    int mayor = componente_de_slot[a], menor = componente_de_slot[b];
+    if (mayor == menor) return;                // O(1), ya estaban conectados
+    if (miembros_de_componente[mayor].size() < miembros_de_componente[menor].size()) swap(mayor, menor);
+    vector<int> mudados = std::move(miembros_de_componente[menor]);
+    miembros_de_componente[menor].clear();
+    for (int s : mudados) poner_en_componente(s, mayor); // O(|menor|)
+    componentes_libres.push_back(menor);
+    componentes_count--;
+}
+// Complejidad: O(tamaño de la menor); cada usuario se muda a una componente al menos el doble
+// de grande, así que con sólo altas se muda O(log n) veces
+
+void RedSocial::separar_componente(span<const int> semillas) {
+    // Precondición: todas las semillas están en la misma componente, y cada pedazo en que
+    // haya quedado partida tiene alguna. Hay una búsqueda por semilla y siempre avanza la
+    // que menos amistades recorrió. Dos búsquedas que se encuentran se funden en la más
+    // grande; una que se queda sin pendientes recorrió su pedazo entero, que pasa a una
+    // componente nueva. Cuando queda una sola, su pedazo es lo que resta de la componente
+    // original y no hace falta terminar de recorrerlo
+    struct Busqueda {
+        vector<int> visitados;
+        vector<int> pendientes;
+        long long recorridas = 0;
+        int unida_a;                           // ella misma, o la búsqueda en la que se fundió
+        bool terminada = false;
+    };
+    const uint32_t epoca = nueva_epoca();      // nivel_de_slot guarda la búsqueda que lo visitó
+    vector<Busqueda> busquedas;
+    priority_queue<pair<long long, int>, vector<pair<long long, int>>, greater<>> turnos;
+    for (int s : semillas) {                   // O(k log k)
+        if (epoca_de_slot[s] == epoca) continue; // semilla repetida
+        epoca_de_slot[s] = epoca;
+        nivel_de_slot[s] = busquedas.size();
+        turnos.emplace(0, busquedas.size());
+        busquedas.push_back({{s}, {s}, 0, (int)busquedas.size()});
+    }
+    auto raiz = [&](int b) {
+        while (busquedas[b].unida_a != b) b = busquedas[b].unida_a = busquedas[busquedas[b].unida_a].unida_a;
+        return b;
+    };
+
+    int activas = busquedas.size();
+    while (activas > 1) {
+        auto [recorridas, b] = turnos.top();
+        turnos.pop();
+        if (raiz(b) != b || busquedas[b].terminada || busquedas[b].recorridas != recorridas) continue; // turno viejo
+        if (busquedas[b].pendientes.empty()) {
+            int nueva = nueva_componente();    // O(1) amortizado
+            for (int v : busquedas[b].visitados) { // O(|pedazo|)
+                sacar_de_componente(v);
+                poner_en_componente(v, nueva);
+            }
+            busquedas[b].terminada = true;
+            activas--;
+            continue;
+        }
+        int v = busquedas[b].pendientes.back();
+        busquedas[b].pendientes.pop_back();
+        for (int w : amigos_de(v)) {           // O(|amigos[v]|)
+            busquedas[b].recorridas++;
+            if (epoca_de_slot[w] != epoca) {
+                epoca_de_slot[w] = epoca;
+                nivel_de_slot[w] = b;
+                busquedas[b].visitados.push_back(w);
+                busquedas[b].pendientes.push_back(w);
+                continue;
             }
+            int otra = raiz(nivel_de_slot[w]);
+            if (otra == b) continue;
+            // Se funden: la más chica se vuelca en la más grande, que sigue desde acá
+            int grande = b, chica = otra;
+            if (busquedas[grande].visitados.size() < busquedas[chica].visitados.size()) swap(grande, chica);
+            Busqueda & g = busquedas[grande], & c = busquedas[chica];
+            g.visitados.insert(g.visitados.end(), c.visitados.begin(), c.visitados.end());
+            g.pendientes.insert(g.pendientes.end(), c.pendientes.begin(), c.pendientes.end());
+            g.recorridas += c.recorridas;
+            c = Busqueda{{}, {}, 0, grande};
+            b = grande;
+            activas--;
         }
+        turnos.emplace(busquedas[b].recorridas, b); // O(log k)
     }
 }
-// Complejidad: O(grado^2 * log n), donde grado es el grado máximo del usuario
+// Complejidad: O((r + k) log k) con r las amistades recorridas; si la componente se parte, r es
+// a lo sumo del orden de lo que suman los pedazos menos el más grande
 
 void RedSocial::recalcular_mas_popular() {
-    id_mas_popular = -1;                       // O(1)
-    int max_amigos = -1;                       // O(1)
-    
-    // Buscar el usuario con más amigos
-    for (int usuario_id : ids) {               // O(n) iteraciones donde n = |ids|
-        int cant_amigos = amigos[usuario_id].size(); // O(log n), búsqueda + O(1), size()
-        if (cant_amigos > max_amigos) {        // O(1)
-            max_amigos = cant_amigos;          // O(1)
-            id_mas_popular = usuario_id;      // O(1)
-        }
-    }
-    
-    // Actualizar el iterador a los conocidos del más popular
-    if (id_mas_popular != -1) {               // O(1)
-        it_conocidos_mas_popular = conocidos.find(id_mas_popular); // O(log n), búsqueda en map
+    INSTRUMENTAR(recalcular_mas_popular);
+    if (ids.empty()) {
+        slot_mas_popular = -1;                 // O(1), no hay usuarios
+        id_mas_popular = -1;
+        return;
+    }
+    // El primero del ranking: la mayor cantidad de amigos y, a igualdad, el menor id
+    id_mas_popular = ranking.begin()->second; // O(1)
+    slot_mas_popular = slot_de_id.at(id_mas_popular); // O(1) promedio
+}
+// Complejidad: O(1) promedio
+
+void RedSocial::mover_de_grado(int slot, int grado_viejo, int grado_nuevo) {
+    sacar_de_grado(slot, grado_viejo);         // O(log n)
+    poner_en_grado(slot, grado_nuevo);         // O(log n)
+}
+// Complejidad: O(log n)
+
+void RedSocial::sacar_de_grado(int slot, int grado) {
+    ranking.erase({-grado, id_de_slot[slot]}); // O(log n)
+}
+// Complejidad: O(log n)
+
+void RedSocial::poner_en_grado(int slot, int grado) {
+    ranking.insert({-grado, id_de_slot[slot]}); // O(log n)
+}
+// Complejidad: O(log n)
+
+void RedSocial::ajustar_amigo_en_comun(int a, int b, int delta) {
+    // b es (o era) amigo de a: para cada otro amigo w de b que no sea amigo de a,
+    // b es un amigo en común entre a y w. Si w sí es amigo de a, (a, b, w) es un
+    // triángulo que aparece o desaparece con la amistad
+    int cerrados = 0;
+    for (int w : amigos[b]) {                  // O(|amigos[b]|) iteraciones
+        if (w == a) continue;
+        if (!es_amigo(a, w)) {                 // O(1) con índice, sino O(log |amigos[a]|)
+            ajustar_conocido(a, w, delta);     // O(1) promedio
+            ajustar_conocido(w, a, delta);     // O(1) promedio
+        } else {
+            cerrados++;
+            // La vuelta simétrica (b, a) encuentra los mismos w: el tercero se cuenta en una sola
+            if (triangulos_al_dia && a < b) triangulos_de_slot[w] += delta;
+        }
+    }
+    if (triangulos_al_dia) {
+        triangulos_de_slot[a] += delta * cerrados;
+        if (a < b) triangulos_count += delta * cerrados;
+    }
+}
+// Complejidad: O(|amigos[b]| log |amigos[a]|)
+
+void RedSocial::ajustar_conocido(int u, int v, int delta) {
+    marcar_para_publicar(u);                   // O(1) amortizado
+    if (!conocidos_ansiosos[u]) {
+        desactualizar_conocidos(u);            // O(1) amortizado, se recalculará al consultarlo
+        return;
+    }
+    CONTAR(conocidos_ajustados, 1);
+    auto it = conocidos[u].find(v);            // O(1) promedio
+    if (it == conocidos[u].end()) {
+        conocidos[u].emplace(v, delta);        // O(1) promedio, sólo ocurre con delta > 0
+        vista_conocidos[u].vigente = false;    // v es un conocido nuevo
+    } else if ((it->second += delta) == 0) {
+        conocidos[u].erase(it);                // O(1), no quedan amigos en común
+        vista_conocidos[u].vigente = false;
+    }
+}
+// Complejidad: O(1) promedio
+
+void RedSocial::fijar_conocido(int u, int v, int en_comun) {
+    marcar_para_publicar(u);                   // O(1) amortizado
+    if (!conocidos_ansiosos[u]) {
+        desactualizar_conocidos(u);            // O(1) amortizado, se recalculará al consultarlo
+        return;
+    }
+    CONTAR(conocidos_ajustados, 1);
+    if (en_comun == 0) {
+        if (conocidos[u].erase(v) > 0) {       // O(1) promedio
+            vista_conocidos[u].vigente = false;
+        }
     } else {
-        it_conocidos_mas_popular = conocidos.end(); // O(1)
+        if (conocidos[u].insert_or_assign(v, en_comun).second) { // O(1) promedio
+            vista_conocidos[u].vigente = false; // v es un conocido nuevo
+        }
     }
 }
-// Complejidad: O(n * log n) donde n es el número de usuarios
\ No newline at end of file
+// Complejidad: O(1) promedio
+
+const RedSocial::Conocidos & RedSocial::conocidos_al_dia_de(int slot) const {
+    if (!conocidos_al_dia[slot]) {
+        if (respaldo && respaldo->tiene_conocidos(slot)) {
+            for (auto [v, en_comun] : respaldo->conocidos(slot)) { // O(c), copia de la instantánea
+                conocidos[slot].emplace(v, en_comun);
+            }
+            conocidos_al_dia[slot] = true;
+            vista_conocidos[slot].vigente = false;
+        } else {
+            reconstruir_conocidos_de(slot);    // O(grado^2 log grado), queda en caché
+        }
+    }
+    return conocidos[slot];
+}
+// Complejidad: O(1) si están al día, O(c) si se copian de la instantánea abierta, O(grado^2 log grado)
+// si hay que calcularlos
+
+void RedSocial::desactualizar_conocidos(int slot) const {
+    if (!conocidos_al_dia[slot]) return;       // O(1), ya estaba desactualizado
+    CONTAR(conocidos_desactualizados, 1);
+    conocidos[slot].clear();                   // O(|conocidos[slot]|), libera la caché
+    conocidos_al_dia[slot] = false;
+    vista_conocidos[slot].vigente = false;
+}
+// Complejidad: O(|conocidos[slot]|), que se paga una sola vez por cada cálculo
+
+void RedSocial::invalidar_vistas(int slot) {
+    vista_amigos[slot].vigente = false;
+    vista_conocidos[slot].vigente = false;
+    marcar_para_publicar(slot);                // O(1) amortizado
+}
+// Complejidad: O(1) amortizado
+
+void RedSocial::marcar_para_publicar(int slot) {
+    if (!publicando || publicar_todo) return;  // O(1), nadie lee versiones o se rearma todo
+    if (slot >= (int)marcado_para_publicar.size()) {
+        marcado_para_publicar.resize(id_de_slot.size(), false); // O(1) amortizado
+    }
+    if (!marcado_para_publicar[slot]) {
+        marcado_para_publicar[slot] = true;
+        por_publicar.push_back(slot);          // O(1) amortizado
+    }
+}
+// Complejidad: O(1) amortizado
+
+const set<string> & RedSocial::materializar(Vista & vista, span<const int> slots) const {
+    if (!vista.vigente) {
+        CONTAR(vistas_materializadas, 1);
+        vista.alias.clear();                   // O(|vista.alias|)
+        for (int s : slots) {                  // O(k) iteraciones
+            vista.alias.emplace_hint(vista.alias.end(), alias_de(s)); // O(log k)
+        }
+        vista.vigente = true;
+    }
+    return vista.alias;
+}
+// Complejidad: O(1) si la vista está vigente, O(k log k) si no, donde k = |slots|
+
+const set<string> & RedSocial::materializar(Vista & vista, const Conocidos & slots) const {
+    if (!vista.vigente) {
+        CONTAR(vistas_materializadas, 1);
+        vista.alias.clear();                   // O(|vista.alias|)
+        for (const auto& [s, en_comun] : slots) { // O(k) iteraciones
+            vista.alias.emplace(alias_de(s)); // O(log k)
+        }
+        vista.vigente = true;
+    }
+    return vista.alias;
+}
+// Complejidad: O(1) si la vista está vigente, O(k log k) si no, donde k = |slots|
+
+bool RedSocial::contiene(span<const int> v, int slot) {
+    return binary_search(v.begin(), v.end(), slot);
+}
+// Complejidad: O(log |v|)
+
+bool RedSocial::insertar_ordenado(ListaDeAmigos & v, int slot) {
+    auto it = lower_bound(v.begin(), v.end(), slot); // O(log |v|)
+    if (it != v.end() && *it == slot) return false;
+    v.insert(it, slot);                        // O(|v|), corrimiento de elementos
+    return true;
+}
+// Complejidad: O(|v|)
+
+bool RedSocial::borrar_ordenado(ListaDeAmigos & v, int slot) {
+    auto it = lower_bound(v.begin(), v.end(), slot); // O(log |v|)
+    if (it == v.end() || *it != slot) return false;
+    v.erase(it);                               // O(|v|), corrimiento de elementos
+    return true;
+}
+// Complejidad: O(|v|)
+
+uint64_t RedSocial::clave_de_par(int a, int b) {
+    return (uint64_t)min(a, b) << 32 | (uint32_t)max(a, b);
+}
+// Complejidad: O(1)
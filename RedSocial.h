@@ -2,93 +2,532 @@
 #define __REDSOCIAL_H__
 
 #include <string>
+#include <string_view>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
+#include <span>
 #include <string>
+#include <utility>
+#include <vector>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include "ArenaDeAlias.h"
+#include "Bitacora.h"
+#include "Instrumentacion.h"
+#include "MapaDeBits.h"
+#include "VersionRedSocial.h"
 using namespace std;
 
+class Instantanea;
+
 class RedSocial{
   public:
-    RedSocial(); // O(1)
+    // Cómo se mantienen los conocidos de un usuario: 'ansioso' los actualiza en cada
+    // cambio de amistad; 'perezoso' los calcula recién al consultarlos y los guarda
+    // hasta que una amistad de su vecindario los invalide
+    enum class ModoConocidos { ansioso, perezoso };
+
+    // Las listas de amigos y los conocidos, que son casi toda la memoria de la red, se
+    // piden a 'memoria' (por ejemplo un pool o una arena de std::pmr). Como cargar_en_bloque
+    // y reconstruir_todo calculan conocidos en varios hilos a la vez, el recurso tiene que admitir
+    // pedidos concurrentes, como synchronized_pool_resource; si no, no hay que usarlas
+    // ni cargar_desde_archivo. Tiene que vivir más que la red
+    RedSocial(ModoConocidos modo = ModoConocidos::ansioso,
+              pmr::memory_resource * memoria = pmr::get_default_resource()); // O(1)
 
     const set<int> & usuarios() const; // O(1)
-    string obtener_alias(int id) const; // O(log n)
-    const set<string> & obtener_amigos(int id) const; // O(log n)
+    string_view obtener_alias(int id) const; // O(1) promedio; vale hasta que se elimine el usuario
+    const set<string> & obtener_amigos(int id) const; // O(1) promedio si la vista está vigente
     int cantidad_amistades() const; // O(1)
 
-    void registrar_usuario(string alias, int id); // O(log n) + O(1) promedio
+    void registrar_usuario(string_view alias, int id); // O(log n) + O(|alias|) promedio
     void eliminar_usuario(int id); // sin requerimiento
     void amigar_usuarios(int id_A, int id_B); // sin requerimiento
     void desamigar_usuarios(int id_A, int id_B); // sin requerimiento
-    
-    int obtener_id(string alias) const; // O(1) promedio
-    const set<string> & obtener_conocidos(int id) const; // O(log n)
-    const set<string> & conocidos_del_usuario_mas_popular() const; // O(1)
+
+    int obtener_id(string_view alias) const; // O(1) promedio, sin copiar el alias
+    const set<string> & obtener_conocidos(int id) const; // O(1) promedio si la vista está vigente
+    const set<string> & conocidos_del_usuario_mas_popular() const; // O(1) si la vista está vigente
+
+    // Ranking por cantidad de amigos, de mayor a menor; a igual cantidad va primero el id
+    // menor, y el primero del ranking es el usuario más popular
+    vector<int> mas_populares(int k) const; // O(k)
+    int puesto_por_grado(int id) const; // O(log n), empezando en 1
+
+    // Amigos en común entre dos usuarios (ids ordenados) y su cantidad, intersecando las
+    // listas ordenadas de slots (ver Interseccion.h)
+    vector<int> amigos_en_comun(int id_A, int id_B) const; // O(k_A + k_B + r log r), r = resultado
+    int cantidad_amigos_en_comun(int id_A, int id_B) const; // O(1) promedio si ya son conocidos, sino O(k_A + k_B)
+
+    // Recomendaciones: los n conocidos con más amigos en común, de mayor a menor y a igual
+    // cantidad por id, como pares (id, amigos en común). Se eligen con un heap de a lo sumo
+    // n elementos sobre los conocidos ya contados, sin armar sus alias; los ids de
+    // 'excluidos' que no estén registrados se ignoran
+    vector<pair<int, int>> recomendar_conocidos(int id, int n, span<const int> excluidos = {}) const; // O(c log n + e)
+
+    // Grados de separación. distancia es la cantidad mínima de amistades entre dos usuarios
+    // (0 consigo mismo, -1 si no están conectados), con un BFS que avanza desde los dos
+    // extremos y expande siempre el lado cuya frontera tiene menos amistades para recorrer.
+    // vecindario son los ids a distancia entre 1 y k, ordenados; su BFS alterna entre
+    // recorrer las amistades de la frontera y, cuando la frontera tiene más amistades que
+    // una fracción de las que quedan sin visitar, revisar cada usuario no visitado contra
+    // un mapa de bits de la frontera, que se reparte en 'cantidad_hilos' hilos
+    int distancia(int id_A, int id_B) const; // O(amistades de los dos lados hasta encontrarse)
+    vector<int> vecindario(int id, int k, int cantidad_hilos = 1) const; // O(Σ grado visitado + r log r), con niveles de O(n + m) / hilos
+
+    // Triángulos: tres usuarios amigos entre sí. Se mantienen en cada cambio de amistad con
+    // el mismo recorrido que ajusta los conocidos (un amigo de B que también es amigo de A
+    // cierra un triángulo), y se cuentan todos de nuevo, en paralelo, en reconstruir_todo o
+    // en la primera consulta después de abrir una instantánea. El coeficiente de
+    // agrupamiento de un usuario es la fracción de pares de amigos suyos que son amigos
+    // entre sí (0 con menos de dos amigos); el global es 3 * triángulos / caminos de largo 2
+    long long triangulos(int id) const; // O(1) promedio si están al día
+    double coeficiente_de_agrupamiento(int id) const; // O(1) promedio si están al día
+    long long cantidad_triangulos() const; // O(1) si están al día
+    double coeficiente_de_agrupamiento_global() const; // O(n) si están al día
+
+    // Componentes conexas: los usuarios unidos por alguna cadena de amistades. Amigar une
+    // dos componentes pasando los usuarios de la menor a la mayor; desamigar o eliminar a
+    // alguien busca desde los que perdieron la amistad, avanzando siempre la búsqueda que
+    // menos recorrió, hasta que se encuentran o alguna se queda sin usuarios: esa es una
+    // componente nueva, y no hace falta recorrer la otra. Se calculan todas de nuevo, en
+    // paralelo, en reconstruir_todo o en la primera consulta después de abrir una instantánea
+    bool misma_componente(int id_A, int id_B) const; // O(1) promedio si están al día
+    int tamanio_de_componente(int id) const; // O(1) promedio si están al día
+    int cantidad_componentes() const; // O(1) si están al día
+
+    // Recorridos de amigos y conocidos como rangos de C++20 de ids, sin armar los conjuntos
+    // de alias. Los amigos salen en el orden de la lista de slots; los conocidos se generan
+    // sobre la marcha desde las listas de amigos, agrupados por su primer amigo en común.
+    // Una ficha marca dónde retomar: la devuelve cada página, y 0 es el principio. Como
+    // está hecha de slots y no de posiciones, una ficha vieja sigue sirviendo después de
+    // modificar la red; los rangos, en cambio, valen mientras la red no se modifique
+    struct IdDeSlot {
+        const RedSocial * red;
+        int operator()(int slot) const { return red->id_de_slot[slot]; }
+    };
+    using RangoDeAmigos = ranges::transform_view<span<const int>, IdDeSlot>;
+
+    class RangoDeConocidos : public ranges::view_interface<RangoDeConocidos> {
+      public:
+        class iterador {
+          public:
+            using value_type = int;
+            using difference_type = ptrdiff_t;
+
+            iterador() = default;
+            int operator*() const; // O(1)
+            iterador & operator++(); // hasta el próximo conocido; ver avanzar en RedSocial.cpp
+            void operator++(int) { ++*this; }
+            bool operator==(default_sentinel_t) const; // O(1)
+            uint64_t ficha() const; // O(1), retoma en este conocido
+
+          private:
+            friend class RangoDeConocidos;
+            void avanzar();
+            bool es_primera_vez(int w) const;
+
+            const RedSocial * red = nullptr;
+            int slot = -1;
+            span<const int> amigos_u;
+            size_t i = 0; // posición del amigo en común en amigos_u
+            size_t j = 0; // posición del conocido en la lista de ese amigo
+        };
+
+        RangoDeConocidos() = default;
+        RangoDeConocidos(const RedSocial * red, int slot, uint64_t ficha);
+        iterador begin() const; // O(1)
+        default_sentinel_t end() const { return default_sentinel; }
+
+      private:
+        iterador inicio;
+    };
+
+    RangoDeAmigos amigos_desde(int id, uint64_t ficha = 0) const; // O(log k)
+    RangoDeConocidos conocidos_desde(int id, uint64_t ficha = 0) const; // O(log k + log |amigos[f]|)
+
+    // Páginas de a lo sumo 'limite' ids; 'siguiente' es la ficha de la próxima página
+    struct Pagina {
+        vector<int> ids;
+        uint64_t siguiente = 0;
+        bool hay_mas = false;
+    };
+    Pagina pagina_de_amigos(int id, int limite, uint64_t ficha = 0) const; // O(log k + limite)
+    Pagina pagina_de_conocidos(int id, int limite, uint64_t ficha = 0) const; // O(log k + caminos recorridos)
+
+    // Transacciones de amistades: una Transaccion anota altas y bajas sin tocar la red, y
+    // de cada par sólo se queda con el último cambio, así que amigar y desamigar el mismo
+    // par se cancelan. Al confirmarla se descartan los pares que ya estaban así y el resto
+    // se aplica de una vez, como en recuperar: una sola mezcla por lista de amigos, una
+    // sola actualización por par de conocidos y un solo recálculo del más popular. Si
+    // algún id no está registrado, confirmar lanza out_of_range antes de modificar nada.
+    // Como los lectores sólo ven lo publicado y confirmar no publica, pasan del estado
+    // anterior al posterior de una vez. La transacción no puede sobrevivir a la red
+    class Transaccion {
+      public:
+        void amigar_usuarios(int id_A, int id_B); // O(1) promedio; consigo mismo no hace nada
+        void desamigar_usuarios(int id_A, int id_B); // O(1) promedio
+        int pendientes() const; // O(1), pares con algún cambio anotado
+        void confirmar(); // O(p) más aplicar los cambios netos; queda vacía
+        void descartar(); // O(p), queda vacía
+
+      private:
+        friend class RedSocial;
+        explicit Transaccion(RedSocial & red) : red(&red) {}
+
+        RedSocial * red;
+        unordered_map<uint64_t, bool> quedan_amigos; // clave_de_par de ids -> estado final
+    };
+    Transaccion transaccion(); // O(1)
+
+    // Carga masiva: registra los usuarios, agrega las amistades y recién al final
+    // calcula los conocidos de todos (en paralelo) y el más popular
+    void cargar_en_bloque(const vector<pair<string, int>> & nuevos_usuarios,
+                          const vector<pair<int, int>> & nuevas_amistades); // O(n + m log m + Σ grado^2)
+    void cargar_desde_archivo(const string & ruta); // idem cargar_en_bloque + lectura del archivo
+
+    // Vuelve a calcular, desde las listas de amigos, todo lo que se deriva de ellas: los
+    // conocidos de todos los ansiosos (los perezosos quedan para cuando se consulten), los
+    // índices de los hubs, el ranking, la cantidad de amistades, los triángulos y las
+    // componentes. Sirve después de una
+    // importación o si se sospecha que algo quedó inconsistente. Usa 'cantidad_hilos'
+    // hilos (0: uno por núcleo), que se reparten a los usuarios por su costo y se roban
+    // trabajo entre sí; el recurso de memoria tiene que admitir pedidos concurrentes,
+    // como en cargar_en_bloque
+    void reconstruir_todo(int cantidad_hilos = 0); // O(n log n + m + Σ grado^2 log grado) / hilos
+
+    // Cambia el modo de un usuario puntual, por ejemplo para mantener ansiosos a los más
+    // consultados en una red perezosa
+    void fijar_modo_conocidos(int id, ModoConocidos modo); // O(grado^2 log grado) al pasar a ansioso
+
+    // Instantáneas binarias (ver Instantanea.h). abrir_instantanea reemplaza el contenido
+    // actual y deja amigos y conocidos mapeados en memoria, de sólo lectura; la primera
+    // modificación posterior los copia a memoria propia
+    void guardar_instantanea(const string & ruta, bool con_conocidos = true) const; // O(n + m + Σ c)
+    void abrir_instantanea(const string & ruta); // O(n log n), sin recalcular conocidos
+
+    // Bitácora de escritura anticipada (ver Bitacora.h): desde que se activa, cada
+    // modificación se anota en 'ruta' y se confirma en disco de a grupos de
+    // 'registros_por_grupo', con un solo fdatasync por grupo. Lo que no se confirmó se
+    // pierde si el proceso se cae
+    void activar_bitacora(const string & ruta, int registros_por_grupo = 64); // O(tamaño del archivo)
+    void confirmar_bitacora(); // escribe y sincroniza lo pendiente
+    void desactivar_bitacora(); // confirma lo pendiente y deja de anotar
+    void punto_de_control(const string & ruta_instantanea); // guarda una instantánea y vacía la bitácora
+
+    // Reemplaza el contenido por la instantánea (si el archivo existe) más los registros
+    // de la bitácora posteriores a ella, aplicados en tandas. Devuelve cuántos registros
+    // se aplicaron
+    int recuperar(const string & ruta_instantanea, const string & ruta_bitacora);
+
+    // Lectores concurrentes (ver VersionRedSocial.h): el hilo que modifica la red llama a
+    // publicar() cuando quiere hacer visibles sus cambios, y cualquier hilo obtiene la
+    // última versión publicada con version(), sin esperar al escritor. Hasta el primer
+    // publicar() no se lleva la cuenta de los cambios, y version() devuelve nullptr
+    void publicar(); // O(n / bloque + Σ (k log k) de los usuarios modificados)
+    shared_ptr<const VersionRedSocial> version() const; // O(1)
+
+    // Reporte de instrumentación (ver Instrumentacion.h): siempre trae los tamaños de las
+    // estructuras y, si se compiló con REDSOCIAL_INSTRUMENTACION, también las llamadas y
+    // latencias de cada operación y los contadores de trabajo interno
+    string reporte(FormatoReporte formato = FormatoReporte::texto) const; // O(n + Σ |vistas materializadas| + operaciones * cubetas)
+
+    // Uso de memoria por estructura, en bytes: lo que cada una pide según sus tamaños y
+    // capacidades, con nodos de árbol y de tabla de hash como los arma libstdc++ y sin
+    // contar el redondeo ni las cabeceras del asignador. No incluye la instantánea
+    // mapeada en memoria (mientras haya respaldo) ni las versiones publicadas, que
+    // comparten lo que no cambió. reporte() trae lo mismo, con el prefijo "bytes_"
+    struct UsoDeMemoria {
+        vector<pair<string, size_t>> por_estructura; // siempre las mismas, en el mismo orden
+        size_t total = 0;
+        double bytes_por_usuario = 0; // total / usuarios, 0 si no hay usuarios
+        double bytes_por_amistad = 0; // total / amistades, 0 si no hay amistades
+    };
+    UsoDeMemoria uso_de_memoria() const; // O(n + Σ |vistas materializadas|)
+#ifdef REDSOCIAL_INSTRUMENTACION
+    const Instrumentacion & instrumentacion() const; // O(1)
+    void reiniciar_instrumentacion(); // O(operaciones * cubetas)
+#endif
 
   private:
-    void reconstruir_conocidos_de(int id);
+    // Motor interno: cada usuario ocupa un slot denso, los amigos se guardan
+    // como vectores ordenados de slots y los conocidos junto con la cantidad
+    // de amigos en común. Los alias sólo se resuelven en los bordes de la API
+    // pública.
+    struct Vista {
+        set<string> alias;
+        bool vigente = false;
+    };
+    using ListaDeAmigos = pmr::vector<int>;
+    using Conocidos = pmr::unordered_map<int, int>; // slot de conocido -> amigos en común
+
+    // Hash y comparación del conjunto de slots por alias: leen el alias de cada slot en la
+    // arena, así que el conjunto guarda sólo el slot y se consulta con un string_view
+    struct HashPorAlias {
+        using is_transparent = void;
+        const RedSocial * red;
+        size_t operator()(string_view alias) const { return HashDeAlias{}(alias); }
+        size_t operator()(int slot) const { return HashDeAlias{}(red->alias_de(slot)); }
+    };
+    struct MismoAlias {
+        using is_transparent = void;
+        const RedSocial * red;
+        bool operator()(int a, int b) const { return red->alias_de(a) == red->alias_de(b); }
+        bool operator()(string_view alias, int slot) const { return alias == red->alias_de(slot); }
+        bool operator()(int slot, string_view alias) const { return alias == red->alias_de(slot); }
+    };
+
+    int slot_de(int id) const;
+    string_view alias_de(int slot) const;
+    int nuevo_slot();
+    span<const int> amigos_de(int slot) const;
+    bool es_amigo(int a, int b) const;
+    int contar_en_comun(int a, int b) const;
+    void agregar_amigo(int a, int b);
+    void quitar_amigo(int a, int b);
+    void actualizar_indice(int slot, span<const int> agregados, span<const int> quitados);
+    void hacer_propio();
+    void reiniciar(int cantidad_slots);
+    void anotar(Bitacora::Tipo tipo, int id_A, int id_B, string_view alias = {});
+    void cambios_netos(const unordered_map<uint64_t, bool> & quedan_amigos, vector<pair<int, int>> & altas,
+                       vector<pair<int, int>> & bajas) const;
+    void aplicar_cambios_de_amistad(const vector<pair<int, int>> & altas, const vector<pair<int, int>> & bajas);
+    void reconstruir_conocidos_de(int slot) const;
+    const Conocidos & conocidos_al_dia_de(int slot) const;
+    void desactualizar_conocidos(int slot) const;
+    void fijar_conocido(int u, int v, int en_comun);
     void recalcular_mas_popular();
-    
-    map<int, string> users; // id y alias
+    void contar_triangulos(int cantidad_hilos) const;
+    void contar_componentes(int cantidad_hilos) const;
+    int nueva_componente();
+    void poner_en_componente(int slot, int componente);
+    void sacar_de_componente(int slot);
+    void unir_componentes(int a, int b);
+    void separar_componente(span<const int> semillas);
+    void mover_de_grado(int slot, int grado_viejo, int grado_nuevo);
+    void sacar_de_grado(int slot, int grado);
+    void poner_en_grado(int slot, int grado);
+    void ajustar_amigo_en_comun(int a, int b, int delta);
+    void ajustar_conocido(int u, int v, int delta);
+    void invalidar_vistas(int slot);
+    void marcar_para_publicar(int slot);
+    const set<string> & materializar(Vista & vista, span<const int> slots) const;
+    const set<string> & materializar(Vista & vista, const Conocidos & slots) const;
+
+    uint32_t nueva_epoca() const;
+
+    static bool contiene(span<const int> v, int slot);
+    static bool insertar_ordenado(ListaDeAmigos & v, int slot);
+    static bool borrar_ordenado(ListaDeAmigos & v, int slot);
+    static uint64_t clave_de_par(int a, int b);
+
     set<int> ids; // ids unicos
-    map<int, set<string>> amigos; // id y alias de amigos
+    ArenaDeAlias arena_de_alias; // la única copia de cada alias
+    unordered_set<int, HashPorAlias, MismoAlias> slots_por_alias; // slots ocupados, buscados por alias
+    unordered_map<int, int> slot_de_id; // id externo -> slot denso
+
+    vector<int> id_de_slot; // slot -> id externo, -1 si el slot está libre
+    vector<ArenaDeAlias::Alias> alias_de_slot; // slot -> alias en arena_de_alias
+    // Los vectores de afuera también usan el recurso, y se lo pasan a cada lista que construyen
+    pmr::vector<ListaDeAmigos> amigos; // slot -> slots de amigos, ordenados
+    ModoConocidos modo_conocidos; // modo de los usuarios nuevos
+    vector<char> conocidos_ansiosos; // slot -> si sus conocidos se mantienen en cada cambio
+
+    // slot -> (slot de conocido -> cantidad de amigos en común). En los slots perezosos
+    // funcionan como caché y se completan al consultarlos
+    mutable pmr::vector<Conocidos> conocidos;
+    mutable vector<char> conocidos_al_dia;
+    vector<int> slots_libres; // slots de usuarios eliminados, para reusar
+
+    // Índice de pertenencia de los usuarios con muchos amigos: se arma al llegar a
+    // grado_de_hub amigos y se descarta al bajar de la mitad, así el borde no lo rearma
+    // en cada cambio. La lista ordenada en amigos sigue siendo la que se recorre
+    static constexpr int grado_de_hub = 1024;
+    vector<unique_ptr<MapaDeBits>> indice_de_amigos; // slot -> índice, o nullptr
+
+    // Instantánea abierta de la que todavía se leen amigos y conocidos, o nullptr
+    shared_ptr<const Instantanea> respaldo;
+
+    // Cantidad de modificaciones hechas desde la red vacía; cada registro de la bitácora
+    // lleva la suya, y las instantáneas guardan la última que incluyen
+    uint64_t secuencia;
+    unique_ptr<Bitacora> bitacora; // nullptr si no hay bitácora activa
+
+#ifdef REDSOCIAL_INSTRUMENTACION
+    mutable Instrumentacion medidas; // la usan INSTRUMENTAR y CONTAR
+#endif
+
+    // Versión publicada para los lectores y los cambios desde entonces: slots con alias,
+    // amigos o conocidos modificados, y si cambió el conjunto de usuarios. Sólo se
+    // anotan una vez que se publicó la primera versión
+    atomic<shared_ptr<const VersionRedSocial>> publicada;
+    bool publicando;
+    bool publicar_todo;
+    bool usuarios_cambiaron;
+    vector<int> por_publicar;
+    vector<char> marcado_para_publicar;
 
-    unordered_map<string, int> alias_to_id;
-    map<int, set<string>> conocidos; // id y alias de conocidos
     int amistades_count;
 
+    // slot -> cantidad de triángulos que lo tienen como vértice, y cuántos hay en total.
+    // Después de abrir una instantánea no están al día hasta la primera consulta
+    mutable vector<long long> triangulos_de_slot;
+    mutable long long triangulos_count;
+    mutable bool triangulos_al_dia;
+
+    // Componentes conexas: slot -> componente (-1 si el slot está libre), componente -> sus
+    // slots en cualquier orden, y slot -> su lugar en esa lista, para sacarlo en O(1). Las
+    // componentes vacías se reusan. Después de abrir una instantánea no están al día hasta
+    // la primera consulta
+    mutable vector<int> componente_de_slot;
+    mutable vector<int> posicion_en_componente;
+    mutable vector<vector<int>> miembros_de_componente;
+    mutable vector<int> componentes_libres;
+    mutable int componentes_count;
+    mutable bool componentes_al_dia;
+
+    // Árbol de estadísticos de orden con un par (-|amigos[s]|, id) por usuario: el orden
+    // del árbol es el del ranking, y cada nodo sabe el tamaño de su subárbol
+    using Ranking = __gnu_pbds::tree<pair<int, int>, __gnu_pbds::null_type, less<pair<int, int>>,
+                                     __gnu_pbds::rb_tree_tag, __gnu_pbds::tree_order_statistics_node_update>;
+    Ranking ranking;
+
     int id_mas_popular;
-    map<int, set<string>>::iterator it_conocidos_mas_popular;
-    
-    
+    int slot_mas_popular;
+
+    // Vistas de alias que devuelve la API pública; se materializan al consultarlas
+    mutable vector<Vista> vista_amigos;
+    mutable vector<Vista> vista_conocidos;
+
+    // Memoria de trabajo de los recorridos, para no limpiar un arreglo de n elementos en
+    // cada consulta: un slot fue visitado en la consulta actual sólo si su época es
+    // epoca_actual, y en ese caso nivel_de_slot dice a qué distancia
+    mutable vector<uint32_t> epoca_de_slot;
+    mutable vector<int> nivel_de_slot;
+    mutable uint32_t epoca_actual = 0;
+
+
     /*
     INVARIANTE DE REPRESENTACION
-    
+
     EN ESPAÑOL:
-    - Todos los ids en 'ids' tienen una entrada correspondiente en 'users', 'amigos' y 'conocidos'
-    - Para cada id en users, existe una entrada inversa en alias_to_id
+    - Todos los ids en 'ids' tienen un slot en 'slot_de_id', y el slot guarda ese id en 'id_de_slot'
+    - Los slots que no corresponden a ningún id están en 'slots_libres', tienen id -1 y sus
+      listas de amigos y conocidos vacías
+    - 'id_de_slot', 'alias_de_slot', 'amigos', 'conocidos', 'conocidos_ansiosos', 'conocidos_al_dia',
+      'indice_de_amigos', 'triangulos_de_slot', 'componente_de_slot', 'posicion_en_componente',
+      'vista_amigos' y 'vista_conocidos' tienen todos el mismo tamaño
+    - slots_por_alias tiene exactamente los slots ocupados, y se busca en él por el alias
+      de cada slot
+    - alias_de_slot identifica lugares de arena_de_alias, que guarda una sola copia de cada
+      alias de un slot ocupado; los slots libres tienen el alias ninguno (vacío)
     - Todos los alias son únicos, no vacíos y tienen como máximo 200 caracteres
-    - Las relaciones de amistad son simétricas: si B está en amigos[A], entonces A está en amigos[B]
-    - Los conocidos de un usuario U son aquellos usuarios V tales que existe un usuario W donde:
-      W está en amigos[U], V está en amigos[W], y V NO está en amigos[U]
-    - amistades_count es igual a la suma de |amigos[id]| / 2 para todo id en ids
-    - id_mas_popular es -1 si no hay usuarios, o es un id en ids que tiene la máxima cantidad de amigos
-    - it_conocidos_mas_popular apunta a los conocidos del usuario más popular si existe, sino a conocidos.end()
+    - Mientras haya respaldo, todos los amigos[s] están vacíos y las listas de amigos se leen
+      de respaldo->amigos(s); lo que se dice abajo de amigos[s] vale para amigos_de(s)
+    - Mientras haya respaldo, un slot ansioso puede no estar al día: sus conocidos se copian
+      del respaldo (o se calculan) al consultarlos o en la primera modificación
+    - Cada amigos[s] está ordenado, sin repetidos, y sólo contiene slots ocupados
+    - Los slots ansiosos siempre tienen sus conocidos al día; los slots perezosos que no están
+      al día tienen conocidos[s] vacío, y lo que se dice abajo de conocidos[s] vale sólo
+      para los slots al día
+    - Las claves de conocidos[s] son slots ocupados
+    - Las relaciones de amistad son simétricas: si b está en amigos[a], entonces a está en amigos[b]
+    - Los conocidos de un slot u son aquellos slots v tales que existe un slot w donde:
+      w está en amigos[u], v está en amigos[w], y v NO está en amigos[u]
+    - conocidos[u][v] es la cantidad de amigos en común entre u y v, siempre mayor a cero
+    - amistades_count es igual a la suma de |amigos[s]| / 2 para todo slot s
+    - Sin respaldo, todo slot con al menos grado_de_hub amigos tiene índice, ninguno con menos de
+      grado_de_hub / 2 lo tiene, y cada índice tiene exactamente los elementos de amigos[s].
+      Mientras haya respaldo no hay índices
+    - ranking tiene exactamente un par (-|amigos[s]|, id_de_slot[s]) por cada slot ocupado s, y nada más
+    - Si triangulos_al_dia, triangulos_de_slot[s] es la cantidad de pares de amigos de s que son
+      amigos entre sí (cero en los slots libres) y triangulos_count es la cantidad de triángulos
+      de la red; si no, no dicen nada
+    - Si componentes_al_dia, dos slots ocupados tienen la misma componente si y sólo si hay un
+      camino de amistades entre ellos; cada slot ocupado s está en la posición
+      posicion_en_componente[s] de miembros_de_componente[componente_de_slot[s]], y esas listas
+      no tienen nada más. Las componentes sin miembros son exactamente las de
+      componentes_libres, y componentes_count es la cantidad de las otras. Si no, no dicen nada
+    - id_mas_popular es -1 si no hay usuarios, o es el primero del ranking: el de más amigos y,
+      entre ellos, el de menor id
+    - slot_mas_popular es el slot de id_mas_popular si existe, sino -1
+    - Una vista vigente contiene exactamente los alias de los slots de la lista que refleja
     - Ningún usuario es amigo de sí mismo
     - Ningún usuario es conocido de sí mismo
-    
+    - Si ya se publicó una versión y no hay que rearmarla entera, todo slot cuyo alias, amigos
+      o conocidos difieren de los publicados está en por_publicar, marcado en marcado_para_publicar
+
     EN LOGICA:
-    (∀id : int) id ∈ ids ⟺ (id ∈ claves(users) ∧ id ∈ claves(amigos) ∧ id ∈ claves(conocidos))
-    
-    (∀id : int) id ∈ claves(users) ⟹ users[id] ∈ claves(alias_to_id) ∧ alias_to_id[users[id]] = id
-    
-    (∀alias : string) alias ∈ claves(alias_to_id) ⟹ (alias ≠ "" ∧ |alias| ≤ 200)
-    
-    (∀id_A, id_B : int) id_A ∈ ids ∧ id_B ∈ ids ⟹ 
-        (users[id_B] ∈ amigos[id_A] ⟺ users[id_A] ∈ amigos[id_B])
-    
-    (∀id_U, id_V : int) id_U ∈ ids ∧ id_V ∈ ids ⟹
-        (users[id_V] ∈ conocidos[id_U] ⟺ 
-            (∃id_W : int) id_W ∈ ids ∧ 
-                users[id_W] ∈ amigos[id_U] ∧ 
-                users[id_V] ∈ amigos[id_W] ∧ 
-                users[id_V] ∉ amigos[id_U] ∧
-                id_V ≠ id_U)
-    
-    amistades_count = (Σ id ∈ ids: |amigos[id]|) / 2
-    
-    (ids = ∅ ⟹ id_mas_popular = -1) ∧
-    (ids ≠ ∅ ⟹ id_mas_popular ∈ ids ∧ 
-        (∀id : int) id ∈ ids ⟹ |amigos[id_mas_popular]| ≥ |amigos[id]|)
-    
-    (id_mas_popular = -1 ⟹ it_conocidos_mas_popular = conocidos.end()) ∧
-    (id_mas_popular ≠ -1 ⟹ esValido(it_conocidos_mas_popular) ∧ clave(it_conocidos_mas_popular) = id_mas_popular)
-    
-    (∀id : int) id ∈ ids ⟹ users[id] ∉ amigos[id]
-    
-    (∀id : int) id ∈ ids ⟹ users[id] ∉ conocidos[id]
+    (∀id : int) id ∈ ids ⟺ (id ∈ claves(slot_de_id) ∧ id_de_slot[slot_de_id[id]] = id)
+
+    (∀s : int) 0 ≤ s < |id_de_slot| ⟹ (id_de_slot[s] = -1 ⟺ s ∈ slots_libres)
+
+    (∀s : int) s ∈ slots_libres ⟹ amigos[s] = ∅ ∧ claves(conocidos[s]) = ∅ ∧ conocidos_al_dia[s]
+
+    respaldo ≠ nullptr ⟹ (∀s : int) amigos[s] = ∅
+
+    respaldo = nullptr ⟹ (∀s : int) conocidos_ansiosos[s] ⟹ conocidos_al_dia[s]
+
+    (∀s : int) ¬conocidos_al_dia[s] ⟹ claves(conocidos[s]) = ∅ ∧ ¬vista_conocidos[s].vigente
+
+    (∀s : int) s ∈ slots_por_alias ⟺ id_de_slot[s] ≠ -1
+
+    (∀s : int) id_de_slot[s] = -1 ⟺ alias_de_slot[s] = ArenaDeAlias::ninguno
+
+    (∀s, t : int) s, t ∈ slots_por_alias ∧ s ≠ t ⟹ alias_de(s) ≠ alias_de(t)
+
+    (∀s : int) s ∈ slots_por_alias ⟹ (alias_de(s) ≠ "" ∧ |alias_de(s)| ≤ 200)
+
+    (∀s : int) ordenado(amigos[s])
+
+    (∀a, b : int) b ∈ amigos[a] ⟺ a ∈ amigos[b]
+
+    (∀s : int) indice_de_amigos[s] ≠ nullptr ⟹ respaldo = nullptr ∧ *indice_de_amigos[s] = amigos[s]
+
+    respaldo = nullptr ⟹ (∀s : int) (|amigos[s]| ≥ grado_de_hub ⟹ indice_de_amigos[s] ≠ nullptr) ∧
+        (|amigos[s]| < grado_de_hub / 2 ⟹ indice_de_amigos[s] = nullptr)
+
+    (∀u, v : int) id_de_slot[u] ≠ -1 ∧ id_de_slot[v] ≠ -1 ∧ conocidos_al_dia[u] ⟹
+        (v ∈ claves(conocidos[u]) ⟺
+            (∃w : int) w ∈ amigos[u] ∧ v ∈ amigos[w] ∧ v ∉ amigos[u] ∧ v ≠ u)
+
+    (∀u, v : int) conocidos_al_dia[u] ∧ v ∈ claves(conocidos[u]) ⟹ conocidos[u][v] = |amigos[u] ∩ amigos[v]| > 0
+
+    amistades_count = (Σ s : |amigos[s]|) / 2
+
+    ranking = {(-|amigos[s]|, id_de_slot[s]) | id_de_slot[s] ≠ -1}
+
+    triangulos_al_dia ⟹ (∀s : int) triangulos_de_slot[s] = |{(v, w) | v ∈ amigos[s] ∧ w ∈ amigos[s] ∧ v < w ∧ w ∈ amigos[v]}|
+
+    triangulos_al_dia ⟹ triangulos_count = (Σ s : triangulos_de_slot[s]) / 3
+
+    componentes_al_dia ⟹ (∀u, v : int) id_de_slot[u] ≠ -1 ∧ id_de_slot[v] ≠ -1 ⟹
+        (componente_de_slot[u] = componente_de_slot[v] ⟺ conectados(u, v))
+
+    componentes_al_dia ⟹ (∀s : int) id_de_slot[s] ≠ -1 ⟹
+        miembros_de_componente[componente_de_slot[s]][posicion_en_componente[s]] = s
+
+    componentes_al_dia ⟹ (Σ c : |miembros_de_componente[c]|) = |ids| ∧
+        (∀c : int) (miembros_de_componente[c] = ∅ ⟺ c ∈ componentes_libres) ∧
+        componentes_count = |miembros_de_componente| - |componentes_libres|
+
+    (ids = ∅ ⟹ id_mas_popular = -1 ∧ slot_mas_popular = -1) ∧
+    (ids ≠ ∅ ⟹ (-|amigos[slot_mas_popular]|, id_mas_popular) = min(ranking) ∧
+        slot_mas_popular = slot_de_id[id_mas_popular])
+
+    (∀s : int) vista_amigos[s].vigente ⟹ vista_amigos[s].alias = {alias_de(w) | w ∈ amigos[s]}
+    (∀s : int) vista_conocidos[s].vigente ⟹ vista_conocidos[s].alias = {alias_de(w) | w ∈ claves(conocidos[s])}
+
+    (∀s : int) s ∉ amigos[s]
+
+    (∀s : int) s ∉ claves(conocidos[s])
     */
 };
 
-#endif
\ No newline at end of file
+#endif
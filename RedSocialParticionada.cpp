@@ -0,0 +1,292 @@
+#include "RedSocialParticionada.h"
+#include <algorithm>
+using namespace std;
+
+
+RedSocialParticionada::RedSocialParticionada(int cantidad_particiones) : en_vuelo(0) {
+    int cantidad = max(1, cantidad_particiones);
+    for (int p = 0; p < cantidad; p++) {
+        particiones.push_back(make_unique<Particion>());
+    }
+    for (int p = 0; p < cantidad; p++) {       // recién con todas creadas, porque se mandan mensajes
+        particiones[p]->hilo = thread(&RedSocialParticionada::trabajar, this, p);
+    }
+}
+// Complejidad: O(p), un hilo por partición
+
+RedSocialParticionada::~RedSocialParticionada() {
+    sincronizar();
+    for (auto& particion : particiones) {
+        lock_guard<mutex> lock(particion->m);
+        particion->terminar = true;
+        particion->hay_trabajo.notify_one();
+    }
+    for (auto& particion : particiones) {
+        particion->hilo.join();
+    }
+}
+// Complejidad: la de sincronizar, más O(p)
+
+const set<int> & RedSocialParticionada::usuarios() const{
+    return ids;
+}
+// Complejidad: O(1)
+
+string_view RedSocialParticionada::obtener_alias(int id) const{
+    return alias_de_id.at(id);                 // O(1) promedio; lanza out_of_range si no existe
+}
+// Complejidad: O(1) promedio
+
+const set<string> & RedSocialParticionada::obtener_amigos(int id) const{
+    alias_de_id.at(id);                        // O(1) promedio; lanza out_of_range si no existe
+    sincronizar();
+    const Particion & particion = *particiones[particion_de(id)];
+    return materializar(vista_amigos[id], particion.amigos.at(id)); // O(k log k)
+}
+// Complejidad: O(k log k) donde k = grado del usuario, más esperar lo encolado
+
+int RedSocialParticionada::cantidad_amistades() const{
+    sincronizar();
+    long long extremos = 0;
+    for (const auto& particion : particiones) { // O(p)
+        extremos += particion->extremos;
+    }
+    return extremos / 2;
+}
+// Complejidad: O(p), más esperar lo encolado
+
+void RedSocialParticionada::registrar_usuario(string_view alias, int id){
+    // Si el id se eliminó hace poco, todavía puede haber mensajes en vuelo dirigidos a él
+    // que no deben alcanzar al usuario nuevo
+    if (eliminados_sin_sincronizar.count(id)) {
+        sincronizar();
+    }
+    ids.insert(id);                            // O(log n)
+    const string & guardado = alias_de_id[id] = alias; // O(|alias|), única copia
+    alias_to_id[guardado] = id;                // O(1) promedio
+    enviar(particion_de(id), {TipoMensaje::alta_usuario, id, -1, 0});
+}
+// Complejidad: O(log n) + O(1) promedio
+
+void RedSocialParticionada::eliminar_usuario(int id){
+    auto it = alias_de_id.find(id);
+    if (it == alias_de_id.end()) {
+        throw out_of_range("id no registrado");
+    }
+    alias_to_id.erase(it->second);             // O(1) promedio
+    alias_de_id.erase(it);                     // O(1) promedio
+    ids.erase(id);                             // O(log n)
+    vista_amigos.erase(id);
+    vista_conocidos.erase(id);
+    eliminados_sin_sincronizar.insert(id);     // O(log n)
+    enviar(particion_de(id), {TipoMensaje::baja_usuario, id, -1, 0});
+}
+// Complejidad: O(log n) en este hilo; O(k^2) mensajes en las particiones, k = grado del usuario
+
+void RedSocialParticionada::amigar_usuarios(int id_A, int id_B){
+    alias_de_id.at(id_A);                      // O(1) promedio; lanza out_of_range si no existe
+    alias_de_id.at(id_B);
+    enviar(particion_de(id_A), {TipoMensaje::alta_amistad, id_A, id_B, 0});
+    enviar(particion_de(id_B), {TipoMensaje::alta_amistad, id_B, id_A, 0});
+}
+// Complejidad: O(1) promedio en este hilo; O(k) mensajes en cada partición, k = grado de cada uno
+
+void RedSocialParticionada::desamigar_usuarios(int id_A, int id_B){
+    alias_de_id.at(id_A);                      // O(1) promedio; lanza out_of_range si no existe
+    alias_de_id.at(id_B);
+    enviar(particion_de(id_A), {TipoMensaje::baja_amistad, id_A, id_B, 0});
+    enviar(particion_de(id_B), {TipoMensaje::baja_amistad, id_B, id_A, 0});
+}
+// Complejidad: O(1) promedio en este hilo; O(k) mensajes en cada partición, k = grado de cada uno
+
+int RedSocialParticionada::obtener_id(string_view alias) const{
+    auto it = alias_to_id.find(alias);         // O(1) promedio, sin armar un string
+    if (it == alias_to_id.end()) {
+        throw out_of_range("alias no registrado");
+    }
+    return it->second;
+}
+// Complejidad: O(1) promedio
+
+const set<string> & RedSocialParticionada::obtener_conocidos(int id) const{
+    alias_de_id.at(id);                        // O(1) promedio; lanza out_of_range si no existe
+    sincronizar();
+    const Particion & particion = *particiones[particion_de(id)];
+    const vector<int> & sus_amigos = particion.amigos.at(id);
+    vector<int> conocidos;
+    auto it = particion.en_comun.find(id);
+    if (it != particion.en_comun.end()) {
+        for (const auto& [v, en_comun] : it->second) { // O(c) iteraciones
+            if (!binary_search(sus_amigos.begin(), sus_amigos.end(), v)) { // O(log k)
+                conocidos.push_back(v);        // los amigos de sus amigos que no son amigos suyos
+            }
+        }
+    }
+    return materializar(vista_conocidos[id], conocidos);
+}
+// Complejidad: O(c log k) donde c = amigos de sus amigos y k = su grado, más esperar lo encolado
+
+const set<string> & RedSocialParticionada::conocidos_del_usuario_mas_popular() const{
+    sincronizar();
+    // Cada partición conoce su propio más popular; alcanza con comparar p candidatos. Como
+    // en RedSocial, a igual cantidad de amigos gana el menor id
+    pair<int, int> mejor = {1, -1};
+    for (const auto& particion : particiones) { // O(p)
+        if (!particion->por_grado.empty()) {
+            mejor = min(mejor, *particion->por_grado.begin());
+        }
+    }
+    if (mejor.second == -1) {
+        vista_mas_popular.clear();             // no hay usuarios
+        return vista_mas_popular;
+    }
+    vista_mas_popular = obtener_conocidos(mejor.second);
+    return vista_mas_popular;
+}
+// Complejidad: O(p + c log k), más esperar lo encolado
+
+void RedSocialParticionada::sincronizar() const{
+    unique_lock<mutex> lock(m_quieto);
+    quieto.wait(lock, [&]() { return en_vuelo.load() == 0; });
+    eliminados_sin_sincronizar.clear();        // ya no queda nada dirigido a ellos
+}
+// Complejidad: lo que tarden las particiones en procesar lo encolado
+
+
+
+// Funciones auxiliares
+
+int RedSocialParticionada::particion_de(int id) const {
+    return hash<int>()(id) % particiones.size();
+}
+// Complejidad: O(1)
+
+void RedSocialParticionada::enviar(int particion, const Mensaje & mensaje) {
+    en_vuelo.fetch_add(1);                     // antes de encolar, para que nunca baje a 0 antes de tiempo
+    Particion & destino = *particiones[particion];
+    lock_guard<mutex> lock(destino.m);
+    destino.entrada.push_back(mensaje);
+    destino.hay_trabajo.notify_one();
+}
+// Complejidad: O(1) amortizado
+
+void RedSocialParticionada::enviar(int particion, vector<Mensaje> & mensajes) {
+    en_vuelo.fetch_add(mensajes.size());
+    Particion & destino = *particiones[particion];
+    lock_guard<mutex> lock(destino.m);
+    destino.entrada.insert(destino.entrada.end(), mensajes.begin(), mensajes.end());
+    destino.hay_trabajo.notify_one();
+    mensajes.clear();
+}
+// Complejidad: O(|mensajes|), con un solo lock para todo el lote
+
+void RedSocialParticionada::trabajar(int p) {
+    Particion & particion = *particiones[p];
+    vector<Mensaje> lote;
+    vector<vector<Mensaje>> salida(particiones.size()); // mensajes generados, por destino
+    while (true) {
+        {
+            unique_lock<mutex> lock(particion.m);
+            particion.hay_trabajo.wait(lock, [&]() { return !particion.entrada.empty() || particion.terminar; });
+            if (particion.entrada.empty()) return; // terminar, sin nada pendiente
+            swap(lote, particion.entrada);     // O(1), se toma todo lo encolado de una vez
+        }
+        for (const Mensaje & mensaje : lote) {
+            procesar(particion, mensaje, salida);
+        }
+        // Los mensajes generados se mandan antes de dar por terminados los del lote
+        for (int q = 0; q < (int)salida.size(); q++) {
+            if (!salida[q].empty()) enviar(q, salida[q]);
+        }
+        mensajes_terminados(lote.size());
+        lote.clear();
+    }
+}
+// Complejidad: la de procesar cada mensaje, con un lock por lote y por destino
+
+void RedSocialParticionada::procesar(Particion & particion, const Mensaje & m, vector<vector<Mensaje>> & salida) {
+    // u y v pasan a tener (o dejan de tener) un amigo en común más
+    auto ajustar_par = [&](int u, int v, int delta) {
+        salida[particion_de(u)].push_back({TipoMensaje::ajustar_en_comun, u, v, delta});
+        salida[particion_de(v)].push_back({TipoMensaje::ajustar_en_comun, v, u, delta});
+    };
+
+    switch (m.tipo) {
+        case TipoMensaje::alta_usuario:
+            particion.amigos[m.u];             // O(1) promedio
+            particion.por_grado.insert({0, m.u}); // O(log n)
+            break;
+
+        case TipoMensaje::baja_usuario: {
+            auto it = particion.amigos.find(m.u);
+            vector<int> sus_amigos = std::move(it->second);
+            // Deja de ser amigo en común entre cada par de sus amigos...
+            for (size_t i = 0; i < sus_amigos.size(); i++) { // O(k^2) mensajes
+                for (size_t j = i + 1; j < sus_amigos.size(); j++) {
+                    ajustar_par(sus_amigos[i], sus_amigos[j], -1);
+                }
+            }
+            // ...y cada amigo corta la amistad de su lado, lo que lo saca de los conocidos del resto
+            for (int f : sus_amigos) {         // O(k) mensajes
+                salida[particion_de(f)].push_back({TipoMensaje::baja_amistad, f, m.u, 0});
+            }
+            particion.extremos -= sus_amigos.size();
+            particion.por_grado.erase({-(int)sus_amigos.size(), m.u}); // O(log n)
+            particion.amigos.erase(it);
+            particion.en_comun.erase(m.u);     // O(c)
+            break;
+        }
+
+        case TipoMensaje::alta_amistad:
+        case TipoMensaje::baja_amistad: {
+            auto it = particion.amigos.find(m.u);
+            if (it == particion.amigos.end()) break; // el usuario ya se eliminó
+            vector<int> & lista = it->second;
+            auto pos = lower_bound(lista.begin(), lista.end(), m.v); // O(log k)
+            bool ya_amigos = pos != lista.end() && *pos == m.v;
+            int delta = m.tipo == TipoMensaje::alta_amistad ? +1 : -1;
+            if (ya_amigos == (delta > 0)) break; // no cambia nada
+
+            int grado = lista.size();
+            if (delta > 0) lista.insert(pos, m.v); // O(k)
+            else lista.erase(pos);
+            particion.por_grado.erase({-grado, m.u}); // O(log n)
+            particion.por_grado.insert({-(grado + delta), m.u});
+            particion.extremos += delta;
+
+            // m.u es el amigo en común entre m.v y cada uno de sus otros amigos
+            for (int w : lista) {              // O(k) mensajes
+                if (w != m.v) ajustar_par(m.v, w, delta);
+            }
+            break;
+        }
+
+        case TipoMensaje::ajustar_en_comun: {
+            if (!particion.amigos.count(m.u)) break; // el usuario ya se eliminó
+            auto& suyos = particion.en_comun[m.u];
+            if ((suyos[m.v] += m.delta) == 0) { // O(1) promedio
+                suyos.erase(m.v);
+            }
+            break;
+        }
+    }
+}
+// Complejidad: O(log n) para altas y ajustes, O(k + log n) para amistades y O(k^2) para bajas
+// de usuario, donde k es el grado del usuario de la partición
+
+void RedSocialParticionada::mensajes_terminados(long long cantidad) {
+    if (en_vuelo.fetch_sub(cantidad) == cantidad) {
+        lock_guard<mutex> lock(m_quieto);      // quien espera en sincronizar no puede perderse el aviso
+        quieto.notify_all();
+    }
+}
+// Complejidad: O(1)
+
+const set<string> & RedSocialParticionada::materializar(set<string> & vista, const vector<int> & ids) const {
+    vista.clear();
+    for (int id : ids) {                       // O(k) iteraciones
+        vista.insert(alias_de_id.at(id));      // O(log k)
+    }
+    return vista;
+}
+// Complejidad: O(k log k) donde k = |ids|
@@ -0,0 +1,140 @@
+#ifndef __REDSOCIALPARTICIONADA_H__
+#define __REDSOCIALPARTICIONADA_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ArenaDeAlias.h"
+using namespace std;
+
+// Variante de RedSocial con la misma API, que reparte los usuarios por id entre
+// particiones, cada una atendida por su propio hilo. Las modificaciones se encolan y
+// vuelven enseguida; las particiones se pasan mensajes entre sí para los cambios que
+// cruzan particiones. Las consultas esperan a que no quede ningún mensaje en vuelo,
+// así que siempre ven todas las modificaciones anteriores.
+//
+// Cada partición guarda, para sus usuarios, los amigos y la cantidad de amigos en común
+// con cada amigo de un amigo, incluidos los que también son amigos (los conocidos son
+// los que no lo son). Así cada cambio de amistad se traduce en sumas y restas que
+// conmutan entre sí: el camino u - x - v lo cuenta sólo la partición de x, al procesar
+// la última de sus dos amistades, y cada partición procesa sus mensajes de a uno.
+
+class RedSocialParticionada{
+  public:
+    explicit RedSocialParticionada(int cantidad_particiones = thread::hardware_concurrency());
+    ~RedSocialParticionada(); // espera lo pendiente y termina los hilos
+    RedSocialParticionada(const RedSocialParticionada &) = delete;
+    RedSocialParticionada & operator=(const RedSocialParticionada &) = delete;
+
+    const set<int> & usuarios() const; // O(1)
+    string_view obtener_alias(int id) const; // O(1) promedio; vale hasta que se elimine el usuario
+    const set<string> & obtener_amigos(int id) const; // O(k log k) después de sincronizar
+    int cantidad_amistades() const; // O(p) después de sincronizar, p = cantidad de particiones
+
+    void registrar_usuario(string_view alias, int id); // O(log n + |alias|) + encolar
+    void eliminar_usuario(int id); // O(log n) + encolar; la partición hace O(k^2) envíos
+    void amigar_usuarios(int id_A, int id_B); // O(1) + encolar; cada partición hace O(k) envíos
+    void desamigar_usuarios(int id_A, int id_B); // O(1) + encolar; cada partición hace O(k) envíos
+
+    int obtener_id(string_view alias) const; // O(1) promedio, sin copiar el alias
+    const set<string> & obtener_conocidos(int id) const; // O(c log k) después de sincronizar
+    const set<string> & conocidos_del_usuario_mas_popular() const; // O(p + c log k) después de sincronizar
+
+    // Espera a que todas las particiones terminen lo encolado hasta ahora
+    void sincronizar() const;
+
+  private:
+    enum class TipoMensaje { alta_usuario, baja_usuario, alta_amistad, baja_amistad, ajustar_en_comun };
+
+    // alta_usuario/baja_usuario: u es el usuario. alta_amistad/baja_amistad: u es el
+    // usuario de la partición y v el otro extremo. ajustar_en_comun: en_comun[u][v] += delta
+    struct Mensaje {
+        TipoMensaje tipo;
+        int u;
+        int v;
+        int delta;
+    };
+
+    struct Particion {
+        mutex m;
+        condition_variable hay_trabajo;
+        vector<Mensaje> entrada;
+        bool terminar = false;
+
+        // Sólo los toca el hilo de la partición, o cualquiera mientras no haya mensajes en vuelo
+        unordered_map<int, vector<int>> amigos; // id -> ids de amigos, ordenados
+        unordered_map<int, unordered_map<int, int>> en_comun; // id -> (id -> amigos en común)
+        set<pair<int, int>> por_grado; // (-cantidad de amigos, id): primero el más popular
+        long long extremos = 0; // Σ |amigos[id]|
+
+        thread hilo;
+    };
+
+    int particion_de(int id) const;
+    void enviar(int particion, const Mensaje & mensaje);
+    void enviar(int particion, vector<Mensaje> & mensajes);
+    void trabajar(int particion);
+    void procesar(Particion & particion, const Mensaje & mensaje, vector<vector<Mensaje>> & salida);
+    void mensajes_terminados(long long cantidad);
+    const set<string> & materializar(set<string> & vista, const vector<int> & ids) const;
+
+    vector<unique_ptr<Particion>> particiones;
+
+    // Mensajes encolados que todavía no terminaron de procesarse, incluidos los que
+    // generan al procesarse
+    atomic<long long> en_vuelo;
+    mutable mutex m_quieto;
+    mutable condition_variable quieto;
+
+    // Estado del hilo que usa la API, para validar ids y resolver alias sin esperar
+    set<int> ids;
+    unordered_map<int, string> alias_de_id;
+    MapaPorAlias<string_view, int> alias_to_id; // claves en los valores de alias_de_id
+    mutable set<int> eliminados_sin_sincronizar;
+
+    // Vistas de alias que devuelve la API; valen hasta la próxima consulta del mismo usuario
+    mutable unordered_map<int, set<string>> vista_amigos;
+    mutable unordered_map<int, set<string>> vista_conocidos;
+    mutable set<string> vista_mas_popular;
+
+
+    /*
+    INVARIANTE DE REPRESENTACION (cuando en_vuelo = 0)
+
+    EN ESPAÑOL:
+    - ids, alias_de_id y alias_to_id tienen los mismos usuarios, y alias_to_id es la inversa de alias_de_id
+    - Cada id de ids está en la partición particion_de(id), con su lista de amigos, y en
+      ninguna otra
+    - Cada lista de amigos está ordenada, sin repetidos, sin el propio id, y sólo contiene ids de ids
+    - Las amistades son simétricas
+    - en_comun[u][v] es la cantidad de amigos en común entre u y v, para todo v ≠ u que tenga
+      alguno (sean o no amigos); no hay entradas en cero
+    - por_grado tiene exactamente un par (-|amigos[u]|, u) por cada usuario de la partición
+    - extremos es la suma de |amigos[u]| sobre los usuarios de la partición
+    - eliminados_sin_sincronizar tiene los ids eliminados desde la última sincronización
+
+    EN LOGICA:
+    (∀id : int) id ∈ ids ⟺ id ∈ claves(alias_de_id) ⟺ id ∈ claves(particiones[particion_de(id)].amigos)
+
+    (∀alias : string) alias ∈ claves(alias_to_id) ⟺ alias_de_id[alias_to_id[alias]] = alias
+
+    (∀u, v : int) v ∈ amigos[u] ⟺ u ∈ amigos[v]
+
+    (∀u : int) ordenado(amigos[u]) ∧ u ∉ amigos[u]
+
+    (∀u, v : int) u ∈ ids ∧ v ∈ ids ∧ u ≠ v ⟹
+        (en_comun[u][v] = |amigos[u] ∩ amigos[v]| si es mayor a cero, sino v ∉ claves(en_comun[u]))
+
+    (∀p : particion) p.extremos = (Σ u ∈ claves(p.amigos) : |p.amigos[u]|)
+    */
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "VersionRedSocial.h"
+#include <stdexcept>
+using namespace std;
+
+
+const set<int> & VersionRedSocial::usuarios() const {
+    return *ids;
+}
+// Complejidad: O(1)
+
+string_view VersionRedSocial::obtener_alias(int id) const {
+    return usuario(id).alias;
+}
+// Complejidad: O(1) promedio
+
+const set<string> & VersionRedSocial::obtener_amigos(int id) const {
+    return usuario(id).amigos;
+}
+// Complejidad: O(1) promedio
+
+int VersionRedSocial::cantidad_amistades() const {
+    return amistades_count;
+}
+// Complejidad: O(1)
+
+int VersionRedSocial::obtener_id(string_view alias) const {
+    auto it = alias_to_id->find(alias);        // O(1) promedio, búsqueda heterogénea
+    if (it == alias_to_id->end()) {
+        throw out_of_range("alias no registrado");
+    }
+    return it->second;
+}
+// Complejidad: O(1) promedio
+
+const set<string> & VersionRedSocial::obtener_conocidos(int id) const {
+    return usuario(id).conocidos;
+}
+// Complejidad: O(1) promedio
+
+const set<string> & VersionRedSocial::conocidos_del_usuario_mas_popular() const {
+    static const set<string> vacio;
+    if (slot_mas_popular == -1) {
+        return vacio;                          // O(1), no hay usuarios
+    }
+    return bloques[slot_mas_popular / usuarios_por_bloque]->at(slot_mas_popular % usuarios_por_bloque)->conocidos;
+}
+// Complejidad: O(1)
+
+uint64_t VersionRedSocial::secuencia() const {
+    return secuencia_publicada;
+}
+// Complejidad: O(1)
+
+const VersionRedSocial::Usuario & VersionRedSocial::usuario(int id) const {
+    int slot = slot_de_id->at(id);             // O(1) promedio; lanza out_of_range si no existe
+    return *(*bloques[slot / usuarios_por_bloque])[slot % usuarios_por_bloque];
+}
+// Complejidad: O(1) promedio
@@ -0,0 +1,59 @@
+#ifndef __VERSIONREDSOCIAL_H__
+#define __VERSIONREDSOCIAL_H__
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ArenaDeAlias.h"
+using namespace std;
+
+// Versión inmutable de una RedSocial, armada por RedSocial::publicar(). Todas sus
+// consultas son de sólo lectura, así que cualquier cantidad de hilos puede usarla a la
+// vez, mientras el escritor sigue modificando la red; las referencias que devuelve
+// valen mientras se tenga el shared_ptr a la versión.
+//
+// Las versiones comparten todo lo que no cambió entre una y otra: los usuarios se
+// guardan de a bloques de 'usuarios_por_bloque' slots, y publicar sólo copia los
+// bloques con algún usuario modificado (copy-on-write).
+
+class VersionRedSocial {
+  public:
+    const set<int> & usuarios() const; // O(1)
+    string_view obtener_alias(int id) const; // O(1) promedio
+    const set<string> & obtener_amigos(int id) const; // O(1) promedio
+    int cantidad_amistades() const; // O(1)
+    int obtener_id(string_view alias) const; // O(1) promedio, sin copiar el alias
+    const set<string> & obtener_conocidos(int id) const; // O(1) promedio
+    const set<string> & conocidos_del_usuario_mas_popular() const; // O(1)
+
+    // Secuencia de la última modificación incluida (ver Bitacora.h)
+    uint64_t secuencia() const; // O(1)
+
+  private:
+    friend class RedSocial;
+
+    struct Usuario {
+        string alias;
+        set<string> amigos;
+        set<string> conocidos;
+    };
+    static constexpr int usuarios_por_bloque = 256;
+    using Bloque = array<shared_ptr<const Usuario>, usuarios_por_bloque>;
+
+    const Usuario & usuario(int id) const;
+
+    vector<shared_ptr<const Bloque>> bloques; // slot -> usuario, nullptr en los slots libres
+    shared_ptr<const set<int>> ids;
+    shared_ptr<const unordered_map<int, int>> slot_de_id;
+    shared_ptr<const MapaPorAlias<string, int>> alias_to_id;
+    int amistades_count = 0;
+    int slot_mas_popular = -1;
+    uint64_t secuencia_publicada = 0;
+};
+
+#endif
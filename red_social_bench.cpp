@@ -0,0 +1,258 @@
+#include "RedSocial.h"
+#include "RedSocialParticionada.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Mide las operaciones de RedSocial sobre grafos sintéticos. Imprime una línea JSON
+// por (generador, tamaño, operación), para poder comparar corridas entre versiones:
+//
+//   red_social_bench [--tamanios 1000,10000] [--semilla 42] [--grado 8] [--perezoso]
+//                    [--particiones 8]
+//
+// Con --particiones se mide RedSocialParticionada: sus modificaciones sólo encolan, así
+// que después de cada tanda se reporta aparte lo que tarda en sincronizar.
+//
+// rss_pico_kb es el pico del proceso hasta ese momento (getrusage), por eso los
+// tamaños se recorren de menor a mayor.
+
+struct Grafo {
+    int usuarios;
+    vector<pair<int, int>> amistades;
+};
+
+struct Opciones {
+    vector<int> tamanios = {1000, 10000};
+    unsigned long semilla = 42;
+    int grado = 8;
+    bool perezoso = false;
+    int particiones = 0; // 0: RedSocial
+};
+
+// Cada par aparece una sola vez y nunca hay lazos
+static void agregar_si_nueva(set<pair<int, int>> & vistas, vector<pair<int, int>> & amistades, int a, int b){
+    if (a == b) return;
+    if (vistas.insert({min(a, b), max(a, b)}).second) {
+        amistades.emplace_back(a, b);
+    }
+}
+
+// G(n, m) con m = n * grado / 2 amistades elegidas al azar
+static Grafo erdos_renyi(int n, int grado, mt19937_64 & rng){
+    Grafo g{n, {}};
+    set<pair<int, int>> vistas;
+    uniform_int_distribution<int> usuario(0, n - 1);
+    long long objetivo = (long long)n * grado / 2;
+    while ((long long)g.amistades.size() < objetivo) {
+        agregar_si_nueva(vistas, g.amistades, usuario(rng), usuario(rng));
+    }
+    return g;
+}
+
+// Enganche preferencial: cada usuario nuevo se hace amigo de grado / 2 existentes,
+// elegidos con probabilidad proporcional a su cantidad de amigos
+static Grafo barabasi_albert(int n, int grado, mt19937_64 & rng){
+    Grafo g{n, {}};
+    set<pair<int, int>> vistas;
+    int m = max(1, grado / 2);
+    vector<int> extremos; // cada usuario aparece una vez por amistad
+    for (int u = 1; u <= m && u < n; u++) {
+        agregar_si_nueva(vistas, g.amistades, 0, u);
+        extremos.push_back(0);
+        extremos.push_back(u);
+    }
+    for (int u = m + 1; u < n; u++) {
+        for (int i = 0; i < m; i++) {
+            int v = extremos[uniform_int_distribution<size_t>(0, extremos.size() - 1)(rng)];
+            size_t antes = g.amistades.size();
+            agregar_si_nueva(vistas, g.amistades, u, v);
+            if (g.amistades.size() > antes) {
+                extremos.push_back(u);
+                extremos.push_back(v);
+            }
+        }
+    }
+    return g;
+}
+
+// Fondo Erdős–Rényi ralo más unos pocos centros conectados con el 20% de la red
+static Grafo estrellas(int n, int grado, mt19937_64 & rng){
+    Grafo g = erdos_renyi(n, max(1, grado / 2), rng);
+    set<pair<int, int>> vistas;
+    for (auto [a, b] : g.amistades) vistas.insert({min(a, b), max(a, b)});
+    int centros = max(1, n / 2000);
+    uniform_int_distribution<int> usuario(0, n - 1);
+    for (int c = 0; c < centros; c++) {
+        int centro = usuario(rng);
+        for (int i = 0; i < n / 5; i++) {
+            agregar_si_nueva(vistas, g.amistades, centro, usuario(rng));
+        }
+    }
+    return g;
+}
+
+static long rss_pico_kb(){
+    rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss; // en Linux, en kilobytes
+}
+
+static void reportar(const string & generador, const Grafo & g, const string & operacion,
+                     vector<long long> & latencias_ns){
+    if (latencias_ns.empty()) return;
+    sort(latencias_ns.begin(), latencias_ns.end());
+    long long total_ns = 0;
+    for (long long l : latencias_ns) total_ns += l;
+    auto percentil = [&](double p) {
+        return latencias_ns[min(latencias_ns.size() - 1, (size_t)(p * latencias_ns.size()))];
+    };
+    cout << "{\"generador\":\"" << generador << "\""
+         << ",\"usuarios\":" << g.usuarios
+         << ",\"amistades\":" << g.amistades.size()
+         << ",\"operacion\":\"" << operacion << "\""
+         << ",\"ops\":" << latencias_ns.size()
+         << ",\"ops_por_segundo\":" << (total_ns > 0 ? latencias_ns.size() * 1e9 / total_ns : 0.0)
+         << ",\"p50_ns\":" << percentil(0.50)
+         << ",\"p99_ns\":" << percentil(0.99)
+         << ",\"rss_pico_kb\":" << rss_pico_kb()
+         << "}" << endl;
+}
+
+template <class F>
+static long long medir(F && f){
+    auto inicio = chrono::steady_clock::now();
+    f();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - inicio).count();
+}
+
+// Espera a que se apliquen las modificaciones encoladas; RedSocial las aplica en el momento
+static void esperar(const string &, const Grafo &, RedSocial &){
+}
+
+static void esperar(const string & generador, const Grafo & g, RedSocialParticionada & rs){
+    vector<long long> latencias = {medir([&] { rs.sincronizar(); })};
+    reportar(generador, g, "sincronizar", latencias);
+}
+
+template <class Red>
+static void medir_operaciones(const string & generador, const Grafo & g, Red & rs, mt19937_64 & rng){
+    vector<long long> latencias;
+    uniform_int_distribution<int> usuario(0, g.usuarios - 1);
+
+    latencias.reserve(g.usuarios);
+    for (int id = 0; id < g.usuarios; id++) {
+        string alias = "u" + to_string(id);
+        latencias.push_back(medir([&] { rs.registrar_usuario(alias, id); }));
+    }
+    reportar(generador, g, "registrar_usuario", latencias);
+    esperar(generador, g, rs);
+
+    latencias.clear();
+    latencias.reserve(g.amistades.size());
+    for (auto [a, b] : g.amistades) {
+        latencias.push_back(medir([&] { rs.amigar_usuarios(a, b); }));
+    }
+    reportar(generador, g, "amigar_usuarios", latencias);
+    esperar(generador, g, rs);
+
+    int consultas = min(g.usuarios, 1000);
+    latencias.clear();
+    for (int i = 0; i < consultas; i++) {
+        int id = usuario(rng);
+        latencias.push_back(medir([&] { rs.obtener_conocidos(id); }));
+    }
+    reportar(generador, g, "obtener_conocidos", latencias);
+
+    latencias.clear();
+    for (int i = 0; i < consultas; i++) {
+        latencias.push_back(medir([&] { rs.conocidos_del_usuario_mas_popular(); }));
+    }
+    reportar(generador, g, "conocidos_del_usuario_mas_popular", latencias);
+
+    // Un 10% de las amistades, al azar
+    vector<pair<int, int>> a_cortar = g.amistades;
+    shuffle(a_cortar.begin(), a_cortar.end(), rng);
+    a_cortar.resize(a_cortar.size() / 10);
+    latencias.clear();
+    for (auto [a, b] : a_cortar) {
+        latencias.push_back(medir([&] { rs.desamigar_usuarios(a, b); }));
+    }
+    reportar(generador, g, "desamigar_usuarios", latencias);
+    esperar(generador, g, rs);
+
+    // Un 1% de los usuarios, al azar
+    vector<int> a_eliminar(g.usuarios);
+    for (int id = 0; id < g.usuarios; id++) a_eliminar[id] = id;
+    shuffle(a_eliminar.begin(), a_eliminar.end(), rng);
+    a_eliminar.resize(max(1, g.usuarios / 100));
+    latencias.clear();
+    for (int id : a_eliminar) {
+        latencias.push_back(medir([&] { rs.eliminar_usuario(id); }));
+    }
+    reportar(generador, g, "eliminar_usuario", latencias);
+    esperar(generador, g, rs);
+}
+
+static void correr(const string & generador, const Grafo & g, const Opciones & op, mt19937_64 & rng){
+    if (op.particiones > 0) {
+        RedSocialParticionada rs(op.particiones);
+        medir_operaciones(generador, g, rs, rng);
+    } else {
+        RedSocial rs(op.perezoso ? RedSocial::ModoConocidos::perezoso : RedSocial::ModoConocidos::ansioso);
+        medir_operaciones(generador, g, rs, rng);
+    }
+}
+
+static Opciones leer_opciones(int argc, char ** argv){
+    Opciones op;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--perezoso") {
+            op.perezoso = true;
+        } else if (arg == "--tamanios" && i + 1 < argc) {
+            op.tamanios.clear();
+            stringstream lista(argv[++i]);
+            string tamanio;
+            while (getline(lista, tamanio, ',')) op.tamanios.push_back(stoi(tamanio));
+            sort(op.tamanios.begin(), op.tamanios.end());
+        } else if (arg == "--semilla" && i + 1 < argc) {
+            op.semilla = stoul(argv[++i]);
+        } else if (arg == "--grado" && i + 1 < argc) {
+            op.grado = stoi(argv[++i]);
+        } else if (arg == "--particiones" && i + 1 < argc) {
+            op.particiones = stoi(argv[++i]);
+        } else {
+            cerr << "uso: " << argv[0]
+                 << " [--tamanios 1000,10000] [--semilla 42] [--grado 8] [--perezoso] [--particiones 8]" << endl;
+            exit(1);
+        }
+    }
+    return op;
+}
+
+int main(int argc, char ** argv){
+    Opciones op = leer_opciones(argc, argv);
+
+    const vector<pair<string, Grafo (*)(int, int, mt19937_64 &)>> generadores = {
+        {"erdos_renyi", erdos_renyi},
+        {"barabasi_albert", barabasi_albert},
+        {"estrellas", estrellas},
+    };
+    for (int n : op.tamanios) {
+        for (size_t i = 0; i < generadores.size(); i++) {
+            // Una semilla por (tamaño, generador), así cada corrida es reproducible por separado
+            mt19937_64 rng(op.semilla * 1000003 + n * generadores.size() + i);
+            correr(generadores[i].first, generadores[i].second(n, op.grado, rng), op, rng);
+        }
+    }
+}
@@ -1,8 +1,30 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <thread>
 #include "RedSocial.h"
+#include "RedSocialParticionada.h"
+#include "Interseccion.h"
+#include "MapaDeBits.h"
 
 using namespace std;
 
+// Cuenta las reservas de memoria dinámica, para verificar los caminos que no deben reservar
+static atomic<long long> reservas(0);
+
+void * operator new(size_t bytes) {
+    reservas++;
+    if (void * p = malloc(bytes ? bytes : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+
 TEST(RedSocial, vacia) {
     RedSocial rs;
     
@@ -486,4 +508,1256 @@ TEST(RedSocial, eliminar_usuario_ver_conocidos_popular_no_cambia) {
 
     // el más popular es 1:
     EXPECT_EQ(u1, rs.conocidos_del_usuario_mas_popular());            
-}
\ No newline at end of file
+}
+TEST(RedSocial, reregistrar_usuario_eliminado) {
+    RedSocial rs;
+
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+
+    rs.amigar_usuarios(5,4);
+    rs.amigar_usuarios(4,3);
+
+    set<string> u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+
+    rs.eliminar_usuario(4);
+
+    // el mismo id vuelve con otro alias y no hereda relaciones del anterior
+    rs.registrar_usuario("vir", 4);
+    rs.registrar_usuario("vivi", 1);
+
+    u = {};
+    EXPECT_EQ(u, rs.obtener_amigos(4));
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+    EXPECT_EQ(4, rs.obtener_id("vir"));
+    EXPECT_EQ("vivi", rs.obtener_alias(1));
+
+    rs.amigar_usuarios(4,1);
+    rs.amigar_usuarios(1,3);
+
+    u = {"vir", "tom"};
+    EXPECT_EQ(u, rs.obtener_amigos(1));
+    u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    EXPECT_EQ(2, rs.cantidad_amistades());
+}
+
+TEST(RedSocial, desamigar_usuarios_conserva_conocidos_por_otro_camino) {
+    RedSocial rs;
+
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+    rs.registrar_usuario("vir", 2);
+
+    rs.amigar_usuarios(5,4);
+    rs.amigar_usuarios(5,3);
+    rs.amigar_usuarios(2,4);
+    rs.amigar_usuarios(2,3);
+    rs.amigar_usuarios(5,2);
+    // red de amigos:
+    // 5-4-2-3-5 y 5-2
+
+    // 4-3 son conocidos a través de 5 y de 2
+    set<string> u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+
+    rs.desamigar_usuarios(5,4);
+
+    // 4-3 siguen conocidos a través de 2, y 5-4 pasan a ser conocidos a través de 2
+    u = {"tom", "agus"};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    u = {"gerva"};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+
+    rs.desamigar_usuarios(2,4);
+
+    u = {};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+}
+
+TEST(RedSocial, eliminar_usuario_conserva_conocidos_por_otro_camino) {
+    RedSocial rs;
+
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+    rs.registrar_usuario("vir", 2);
+    rs.registrar_usuario("vivi", 1);
+
+    rs.amigar_usuarios(5,4);
+    rs.amigar_usuarios(5,3);
+    rs.amigar_usuarios(5,1);
+    rs.amigar_usuarios(2,4);
+    rs.amigar_usuarios(2,3);
+    // red de amigos:
+    // 1-5-4-2-3-5
+
+    rs.eliminar_usuario(5);
+
+    // 4-3 siguen conocidos a través de 2; 1 queda aislado
+    EXPECT_EQ(2, rs.cantidad_amistades());
+    set<string> u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    u = {"gerva"};
+    EXPECT_EQ(u, rs.obtener_conocidos(3));
+    u = {};
+    EXPECT_EQ(u, rs.obtener_conocidos(1));
+    EXPECT_EQ(u, rs.obtener_conocidos(2));
+
+    // el más popular ahora es 2, que no tiene conocidos
+    EXPECT_EQ(u, rs.conocidos_del_usuario_mas_popular());
+}
+
+TEST(RedSocial, cargar_en_bloque_equivale_a_cargar_de_a_uno) {
+    vector<pair<string, int>> usuarios = {
+        {"pablo", 7}, {"pepe", 6}, {"agus", 5}, {"gerva", 4},
+        {"tom", 3}, {"vir", 2}, {"vivi", 1}, {"pedro", 0}};
+    // con repetidos y en ambas direcciones
+    vector<pair<int, int>> amistades = {
+        {1,2}, {1,3}, {1,5}, {1,0}, {4,5}, {4,3}, {6,5}, {6,7}, {2,0}, {2,1}, {5,4}};
+
+    RedSocial de_a_uno;
+    for (auto [alias, id] : usuarios) de_a_uno.registrar_usuario(alias, id);
+    de_a_uno.amigar_usuarios(1,2);
+    de_a_uno.amigar_usuarios(1,3);
+    de_a_uno.amigar_usuarios(1,5);
+    de_a_uno.amigar_usuarios(1,0);
+    de_a_uno.amigar_usuarios(4,5);
+    de_a_uno.amigar_usuarios(4,3);
+    de_a_uno.amigar_usuarios(6,5);
+    de_a_uno.amigar_usuarios(6,7);
+    de_a_uno.amigar_usuarios(2,0);
+
+    RedSocial en_bloque;
+    en_bloque.cargar_en_bloque(usuarios, amistades);
+
+    EXPECT_EQ(de_a_uno.usuarios(), en_bloque.usuarios());
+    EXPECT_EQ(9, en_bloque.cantidad_amistades());
+    for (int id : de_a_uno.usuarios()) {
+        EXPECT_EQ(de_a_uno.obtener_amigos(id), en_bloque.obtener_amigos(id));
+        EXPECT_EQ(de_a_uno.obtener_conocidos(id), en_bloque.obtener_conocidos(id));
+    }
+    EXPECT_EQ(de_a_uno.conocidos_del_usuario_mas_popular(), en_bloque.conocidos_del_usuario_mas_popular());
+
+    // después de la carga, las operaciones incrementales siguen funcionando
+    en_bloque.desamigar_usuarios(1,5);
+    set<string> u = {"gerva"};
+    EXPECT_EQ(u, en_bloque.obtener_conocidos(6));
+    u = {"vivi", "pepe"};
+    EXPECT_EQ(u, en_bloque.obtener_conocidos(4));
+}
+
+TEST(RedSocial, cargar_desde_archivo) {
+    string ruta = testing::TempDir() + "red_social_carga.txt";
+    {
+        ofstream archivo(ruta);
+        archivo << "# usuarios y amistades\n"
+                << "usuario 3 tom\n"
+                << "usuario 2 vir\n"
+                << "usuario 1 vivi\n"
+                << "\n"
+                << "amistad 1 2\n"
+                << "amistad 1 3\n";
+    }
+
+    RedSocial rs;
+    rs.cargar_desde_archivo(ruta);
+
+    EXPECT_EQ(2, rs.cantidad_amistades());
+    set<string> u = {"vir", "tom"};
+    EXPECT_EQ(u, rs.obtener_amigos(1));
+    u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(2));
+    u = {};
+    EXPECT_EQ(u, rs.conocidos_del_usuario_mas_popular());
+
+    {
+        ofstream archivo(ruta);
+        archivo << "amistad 1\n";
+    }
+    EXPECT_THROW(rs.cargar_desde_archivo(ruta), runtime_error);
+    EXPECT_THROW(rs.cargar_desde_archivo(ruta + ".no_existe"), runtime_error);
+}
+
+TEST(RedSocial, conocidos_perezosos) {
+    RedSocial rs(RedSocial::ModoConocidos::perezoso);
+
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+    rs.registrar_usuario("vir", 2);
+    rs.registrar_usuario("vivi", 1);
+
+    rs.amigar_usuarios(1,2);
+    rs.amigar_usuarios(1,3);
+
+    set<string> u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(2));
+
+    // lo calculado se invalida cuando cambia una amistad del vecindario
+    rs.amigar_usuarios(3,4);
+    u = {"gerva"};
+    EXPECT_EQ(u, rs.obtener_conocidos(1));
+    u = {"vivi"};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+
+    // un usuario ansioso convive con los perezosos
+    rs.fijar_modo_conocidos(4, RedSocial::ModoConocidos::ansioso);
+    rs.amigar_usuarios(4,5);
+    rs.desamigar_usuarios(1,3);
+
+    u = {};
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+    EXPECT_EQ(u, rs.obtener_conocidos(2));
+    u = {"tom"};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+
+    rs.eliminar_usuario(3);
+    u = {};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+    EXPECT_EQ(u, rs.obtener_conocidos(4));
+}
+
+TEST(RedSocial, guardar_y_abrir_instantanea) {
+    string ruta = testing::TempDir() + "red_social.instantanea";
+
+    RedSocial original;
+    original.registrar_usuario("pablo", 7);
+    original.registrar_usuario("pepe", 6);
+    original.registrar_usuario("agus", 5);
+    original.registrar_usuario("gerva", 4);
+    original.registrar_usuario("tom", 3);
+    original.registrar_usuario("vir", 2);
+    original.registrar_usuario("vivi", 1);
+    original.eliminar_usuario(7); // deja un slot libre
+
+    original.amigar_usuarios(1,2);
+    original.amigar_usuarios(1,3);
+    original.amigar_usuarios(1,5);
+    original.amigar_usuarios(4,5);
+    original.amigar_usuarios(4,3);
+    original.amigar_usuarios(6,5);
+    original.guardar_instantanea(ruta);
+
+    RedSocial rs;
+    rs.registrar_usuario("otro", 99); // se pierde al abrir la instantánea
+    rs.abrir_instantanea(ruta);
+
+    EXPECT_EQ(original.usuarios(), rs.usuarios());
+    EXPECT_EQ(original.cantidad_amistades(), rs.cantidad_amistades());
+    EXPECT_EQ(original.conocidos_del_usuario_mas_popular(), rs.conocidos_del_usuario_mas_popular());
+    for (int id : original.usuarios()) {
+        EXPECT_EQ(original.obtener_alias(id), rs.obtener_alias(id));
+        EXPECT_EQ(id, rs.obtener_id(original.obtener_alias(id)));
+        EXPECT_EQ(original.obtener_amigos(id), rs.obtener_amigos(id));
+        EXPECT_EQ(original.obtener_conocidos(id), rs.obtener_conocidos(id));
+    }
+
+    // la primera modificación copia la instantánea y todo sigue funcionando
+    rs.desamigar_usuarios(1,5);
+    rs.registrar_usuario("pablo", 7);
+    rs.amigar_usuarios(7,6);
+
+    EXPECT_EQ(6, rs.cantidad_amistades());
+    set<string> u = {"agus"};
+    EXPECT_EQ(u, rs.obtener_conocidos(7));
+    u = {"gerva"};
+    EXPECT_EQ(u, rs.obtener_conocidos(1));
+    u = {"tom", "pablo"};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+}
+
+TEST(RedSocial, abrir_instantanea_invalida) {
+    string ruta = testing::TempDir() + "red_social_invalida.instantanea";
+    {
+        ofstream archivo(ruta, ios::binary);
+        archivo << "esto no es una instantánea, aunque sea suficientemente largo para tener cabecera"
+                << string(200, 'x');
+    }
+
+    RedSocial rs;
+    rs.registrar_usuario("tom", 3);
+    EXPECT_THROW(rs.abrir_instantanea(ruta), runtime_error);
+    EXPECT_THROW(rs.abrir_instantanea(ruta + ".no_existe"), runtime_error);
+
+    // si falla, el contenido anterior queda intacto
+    EXPECT_EQ(3, rs.obtener_id("tom"));
+}
+
+TEST(RedSocial, recuperar_desde_instantanea_y_bitacora) {
+    string instantanea = testing::TempDir() + "red_social_recuperar.instantanea";
+    string bitacora = testing::TempDir() + "red_social_recuperar.bitacora";
+    remove(instantanea.c_str());
+    remove(bitacora.c_str());
+
+    RedSocial original;
+    original.activar_bitacora(bitacora, 3);
+    original.registrar_usuario("pablo", 7);
+    original.registrar_usuario("pepe", 6);
+    original.registrar_usuario("agus", 5);
+    original.registrar_usuario("gerva", 4);
+    original.amigar_usuarios(7,6);
+    original.amigar_usuarios(6,5);
+    original.punto_de_control(instantanea);
+
+    // después del punto de control: amistades que se cancelan, bajas y re-registros
+    original.registrar_usuario("tom", 3);
+    original.amigar_usuarios(5,4);
+    original.amigar_usuarios(4,3);
+    original.desamigar_usuarios(4,3);
+    original.amigar_usuarios(3,7);
+    original.desamigar_usuarios(7,6);
+    original.eliminar_usuario(6);
+    original.registrar_usuario("pepa", 6);
+    original.amigar_usuarios(6,3);
+    original.amigar_usuarios(6,4);
+    original.desactivar_bitacora();
+
+    RedSocial rs;
+    EXPECT_EQ(10, rs.recuperar(instantanea, bitacora));
+
+    EXPECT_EQ(original.usuarios(), rs.usuarios());
+    EXPECT_EQ(original.cantidad_amistades(), rs.cantidad_amistades());
+    EXPECT_EQ(original.conocidos_del_usuario_mas_popular(), rs.conocidos_del_usuario_mas_popular());
+    for (int id : original.usuarios()) {
+        EXPECT_EQ(original.obtener_alias(id), rs.obtener_alias(id));
+        EXPECT_EQ(original.obtener_amigos(id), rs.obtener_amigos(id));
+        EXPECT_EQ(original.obtener_conocidos(id), rs.obtener_conocidos(id));
+    }
+
+    // si la caída fue entre guardar la instantánea y vaciar la bitácora, se saltean los
+    // registros que la instantánea ya incluye
+    remove(bitacora.c_str());
+    RedSocial otra;
+    otra.activar_bitacora(bitacora, 1);
+    otra.registrar_usuario("pablo", 7);
+    otra.registrar_usuario("pepe", 6);
+    otra.guardar_instantanea(instantanea);
+    otra.amigar_usuarios(7,6);
+    otra.desactivar_bitacora();
+
+    RedSocial recuperada;
+    EXPECT_EQ(1, recuperada.recuperar(instantanea, bitacora));
+    set<int> ids = {6, 7};
+    EXPECT_EQ(ids, recuperada.usuarios());
+    EXPECT_EQ(1, recuperada.cantidad_amistades());
+}
+
+TEST(RedSocial, bitacora_con_registro_roto_al_final) {
+    string bitacora = testing::TempDir() + "red_social_rota.bitacora";
+    remove(bitacora.c_str());
+
+    RedSocial original;
+    original.activar_bitacora(bitacora, 100);
+    original.registrar_usuario("pablo", 7);
+    original.registrar_usuario("pepe", 6);
+    original.confirmar_bitacora();
+    original.amigar_usuarios(7,6); // queda pendiente: se pierde en la caída
+    {
+        // una caída a mitad de escribir deja un registro incompleto
+        ofstream archivo(bitacora, ios::binary | ios::app);
+        archivo << "\x30\x00\x00";
+    }
+
+    RedSocial rs;
+    EXPECT_EQ(2, rs.recuperar("", bitacora));
+    EXPECT_EQ(0, rs.cantidad_amistades());
+
+    // al reactivarla se descarta el registro roto y lo nuevo se puede leer
+    rs.activar_bitacora(bitacora, 1);
+    rs.amigar_usuarios(7,6);
+    rs.desactivar_bitacora();
+    RedSocial otra;
+    EXPECT_EQ(3, otra.recuperar("", bitacora));
+    EXPECT_EQ(1, otra.cantidad_amistades());
+}
+
+TEST(RedSocial, publicar_versiones) {
+    RedSocial rs;
+    EXPECT_EQ(nullptr, rs.version());
+
+    rs.registrar_usuario("pablo", 7);
+    rs.registrar_usuario("pepe", 6);
+    rs.registrar_usuario("agus", 5);
+    rs.amigar_usuarios(7,6);
+    rs.amigar_usuarios(6,5);
+    rs.publicar();
+    shared_ptr<const VersionRedSocial> v1 = rs.version();
+
+    // los cambios posteriores no se ven hasta publicar, y la versión vieja no cambia
+    rs.desamigar_usuarios(6,5);
+    rs.registrar_usuario("gerva", 4);
+    rs.amigar_usuarios(4,7);
+    EXPECT_EQ(v1, rs.version());
+    rs.publicar();
+    shared_ptr<const VersionRedSocial> v2 = rs.version();
+
+    set<int> ids = {5, 6, 7};
+    EXPECT_EQ(ids, v1->usuarios());
+    EXPECT_EQ(2, v1->cantidad_amistades());
+    set<string> u = {"agus"};
+    EXPECT_EQ(u, v1->obtener_conocidos(7));
+    u = {"pablo", "agus"};
+    EXPECT_EQ(u, v1->obtener_amigos(6));
+    EXPECT_TRUE(v1->conocidos_del_usuario_mas_popular().empty()); // el más popular es pepe
+    EXPECT_THROW(v1->obtener_alias(4), out_of_range);
+
+    ids = {4, 5, 6, 7};
+    EXPECT_EQ(ids, v2->usuarios());
+    EXPECT_EQ(2, v2->cantidad_amistades());
+    EXPECT_EQ("gerva", v2->obtener_alias(4));
+    EXPECT_EQ(4, v2->obtener_id("gerva"));
+    u = {"gerva"};
+    EXPECT_EQ(u, v2->obtener_conocidos(6));
+    EXPECT_EQ(rs.conocidos_del_usuario_mas_popular(), v2->conocidos_del_usuario_mas_popular());
+    for (int id : rs.usuarios()) {
+        EXPECT_EQ(rs.obtener_amigos(id), v2->obtener_amigos(id));
+        EXPECT_EQ(rs.obtener_conocidos(id), v2->obtener_conocidos(id));
+    }
+}
+
+TEST(RedSocial, lectores_concurrentes) {
+    RedSocial rs(RedSocial::ModoConocidos::perezoso);
+    for (int id = 0; id < 50; id++) {
+        rs.registrar_usuario("u" + to_string(id), id);
+    }
+    rs.publicar();
+
+    // Cada versión tiene que ser consistente: amistades simétricas y bien contadas
+    atomic<bool> terminar(false);
+    atomic<int> inconsistencias(0);
+    auto leer = [&]() {
+        while (!terminar) {
+            shared_ptr<const VersionRedSocial> v = rs.version();
+            int extremos = 0;
+            for (int id : v->usuarios()) {
+                for (const string & amigo : v->obtener_amigos(id)) {
+                    extremos++;
+                    if (!v->obtener_amigos(v->obtener_id(amigo)).count(string(v->obtener_alias(id)))) {
+                        inconsistencias++;
+                    }
+                }
+            }
+            if (extremos != 2 * v->cantidad_amistades()) inconsistencias++;
+        }
+    };
+    vector<thread> lectores;
+    for (int i = 0; i < 4; i++) lectores.emplace_back(leer);
+
+    for (int paso = 0; paso < 2000; paso++) {
+        int a = paso % 50, b = (paso * 7 + 3) % 50;
+        if (a == b) continue;
+        if (rs.obtener_amigos(a).count("u" + to_string(b))) {
+            rs.desamigar_usuarios(a, b);
+        } else {
+            rs.amigar_usuarios(a, b);
+        }
+        if (paso % 10 == 0) rs.publicar();
+    }
+    terminar = true;
+    for (auto& lector : lectores) lector.join();
+
+    EXPECT_EQ(0, inconsistencias);
+}
+
+TEST(RedSocial, particionada_basica) {
+    RedSocialParticionada rs(3);
+    rs.registrar_usuario("pablo", 7);
+    rs.registrar_usuario("pepe", 6);
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.amigar_usuarios(7,6);
+    rs.amigar_usuarios(6,5);
+    rs.amigar_usuarios(5,4);
+
+    EXPECT_EQ(3, rs.cantidad_amistades());
+    set<string> u = {"agus"};
+    EXPECT_EQ(u, rs.obtener_conocidos(7));
+    u = {"pablo"};
+    EXPECT_EQ(u, rs.obtener_conocidos(5));
+
+    rs.eliminar_usuario(6);
+    rs.registrar_usuario("pepa", 6);
+    EXPECT_EQ(1, rs.cantidad_amistades());
+    EXPECT_TRUE(rs.obtener_conocidos(7).empty());
+    EXPECT_TRUE(rs.obtener_amigos(6).empty());
+    EXPECT_THROW(rs.amigar_usuarios(6, 99), out_of_range);
+}
+
+TEST(RedSocial, particionada_equivale_a_red_social) {
+    RedSocial esperada;
+    RedSocialParticionada rs(4);
+    mt19937 azar(7);
+    vector<int> vivos;
+    for (int id = 0; id < 40; id++) {
+        esperada.registrar_usuario("u" + to_string(id), id);
+        rs.registrar_usuario("u" + to_string(id), id);
+        vivos.push_back(id);
+    }
+
+    for (int paso = 0; paso < 3000; paso++) {
+        int a = vivos[azar() % vivos.size()], b = vivos[azar() % vivos.size()];
+        int accion = azar() % 20;
+        if (accion == 0 && vivos.size() > 10) {
+            esperada.eliminar_usuario(a);
+            rs.eliminar_usuario(a);
+            vivos.erase(find(vivos.begin(), vivos.end(), a));
+        } else if (accion == 1) {
+            int id = 100 + paso;
+            esperada.registrar_usuario("u" + to_string(id), id);
+            rs.registrar_usuario("u" + to_string(id), id);
+            vivos.push_back(id);
+        } else if (a != b && esperada.obtener_amigos(a).count("u" + to_string(b))) {
+            esperada.desamigar_usuarios(a, b);
+            rs.desamigar_usuarios(a, b);
+        } else if (a != b) {
+            esperada.amigar_usuarios(a, b);
+            rs.amigar_usuarios(a, b);
+        }
+    }
+
+    EXPECT_EQ(esperada.usuarios(), rs.usuarios());
+    EXPECT_EQ(esperada.cantidad_amistades(), rs.cantidad_amistades());
+    for (int id : esperada.usuarios()) {
+        EXPECT_EQ(esperada.obtener_amigos(id), rs.obtener_amigos(id));
+        EXPECT_EQ(esperada.obtener_conocidos(id), rs.obtener_conocidos(id));
+    }
+}
+
+TEST(RedSocial, amigos_en_comun) {
+    RedSocial rs;
+    rs.registrar_usuario("pablo", 7);
+    rs.registrar_usuario("pepe", 6);
+    rs.registrar_usuario("agus", 5);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+    rs.amigar_usuarios(7,5);
+    rs.amigar_usuarios(7,4);
+    rs.amigar_usuarios(7,3);
+    rs.amigar_usuarios(6,4);
+    rs.amigar_usuarios(6,5);
+
+    vector<int> u = {4, 5};
+    EXPECT_EQ(u, rs.amigos_en_comun(7,6));
+    EXPECT_EQ(2, rs.cantidad_amigos_en_comun(7,6));
+    EXPECT_EQ(2, rs.cantidad_amigos_en_comun(6,7));
+
+    // también entre amigos, que no son conocidos
+    rs.amigar_usuarios(6,7);
+    EXPECT_EQ(u, rs.amigos_en_comun(6,7));
+    EXPECT_EQ(2, rs.cantidad_amigos_en_comun(7,6));
+    u = {7};
+    EXPECT_EQ(u, rs.amigos_en_comun(3,6));
+    EXPECT_EQ(1, rs.cantidad_amigos_en_comun(3,4));
+    EXPECT_THROW(rs.amigos_en_comun(7,99), out_of_range);
+}
+
+TEST(RedSocial, interseccion_coincide_con_set_intersection) {
+    mt19937 azar(3);
+    auto lista_al_azar = [&](int largo, int rango) {
+        vector<int> v;
+        for (int i = 0; i < largo; i++) v.push_back(azar() % rango);
+        sort(v.begin(), v.end());
+        v.erase(unique(v.begin(), v.end()), v.end());
+        return v;
+    };
+    // largos parecidos (núcleo vectorizado) y muy distintos (galopando), con colas sueltas
+    for (auto [largo_v, largo_w] : vector<pair<int, int>>{{0, 10}, {3, 5}, {17, 23}, {100, 120},
+                                                            {1000, 900}, {5, 4000}, {40, 10000}}) {
+        for (int rango : {50, 1000, 100000}) {
+            vector<int> v = lista_al_azar(largo_v, rango), w = lista_al_azar(largo_w, rango);
+            vector<int> esperado;
+            set_intersection(v.begin(), v.end(), w.begin(), w.end(), back_inserter(esperado));
+            vector<int> obtenido = {-1}; // agrega al final
+            intersectar(v, w, obtenido);
+            obtenido.erase(obtenido.begin());
+            EXPECT_EQ(esperado, obtenido) << nucleo_de_interseccion();
+            EXPECT_EQ((int)esperado.size(), contar_interseccion(w, v));
+        }
+    }
+}
+
+TEST(RedSocial, ranking_por_grado) {
+    RedSocial rs;
+    EXPECT_TRUE(rs.mas_populares(3).empty());
+    rs.registrar_usuario("pepe", 6);
+    rs.registrar_usuario("gerva", 4);
+    rs.registrar_usuario("tom", 3);
+    rs.registrar_usuario("vir", 2);
+    rs.registrar_usuario("vivi", 1);
+
+    // Todos con cero amigos: el orden es por id
+    EXPECT_EQ(vector<int>({1, 2, 3, 4, 6}), rs.mas_populares(10));
+    EXPECT_EQ(1, rs.puesto_por_grado(1));
+    EXPECT_EQ(5, rs.puesto_por_grado(6));
+
+    rs.amigar_usuarios(6, 4);
+    rs.amigar_usuarios(6, 3);
+    rs.amigar_usuarios(3, 2);
+    // grados: 6 -> 2, 3 -> 2, 4 -> 1, 2 -> 1, 1 -> 0
+    EXPECT_EQ(vector<int>({3, 6}), rs.mas_populares(2));
+    EXPECT_EQ(vector<int>({3, 6, 2, 4, 1}), rs.mas_populares(5));
+    EXPECT_EQ(2, rs.puesto_por_grado(6));
+    EXPECT_EQ(4, rs.puesto_por_grado(4));
+    EXPECT_EQ(set<string>({"gerva"}), rs.conocidos_del_usuario_mas_popular()); // los de 3
+
+    rs.eliminar_usuario(3);
+    // grados: 6 -> 1, 4 -> 1, 2 -> 0, 1 -> 0
+    EXPECT_EQ(vector<int>({4, 6, 1, 2}), rs.mas_populares(4));
+    EXPECT_EQ(1, rs.puesto_por_grado(4));
+    EXPECT_EQ(3, rs.puesto_por_grado(1));
+    EXPECT_THROW(rs.puesto_por_grado(3), out_of_range);
+    EXPECT_TRUE(rs.conocidos_del_usuario_mas_popular().empty());
+
+    // El ranking sobrevive a una instantánea
+    string ruta = testing::TempDir() + "red_social_ranking.instantanea";
+    rs.guardar_instantanea(ruta);
+    RedSocial abierta;
+    abierta.abrir_instantanea(ruta);
+    EXPECT_EQ(rs.mas_populares(4), abierta.mas_populares(4));
+    EXPECT_EQ(3, abierta.puesto_por_grado(1));
+}
+
+TEST(RedSocial, recomendar_conocidos) {
+    RedSocial rs;
+    for (int i = 1; i <= 8; i++) {
+        rs.registrar_usuario("u" + to_string(i), i);
+    }
+    // 1 es amigo de 2, 3 y 4; 5 es amigo de 2, 3 y 4; 6 de 2 y 3; 7 de 4; 8 de 3
+    for (int f : {2, 3, 4}) rs.amigar_usuarios(1, f);
+    for (int f : {2, 3, 4}) rs.amigar_usuarios(5, f);
+    rs.amigar_usuarios(6, 2);
+    rs.amigar_usuarios(6, 3);
+    rs.amigar_usuarios(7, 4);
+    rs.amigar_usuarios(8, 3);
+
+    using Recomendados = vector<pair<int, int>>;
+    EXPECT_EQ(Recomendados({{5, 3}, {6, 2}, {7, 1}, {8, 1}}), rs.recomendar_conocidos(1, 10));
+    EXPECT_EQ(Recomendados({{5, 3}, {6, 2}, {7, 1}}), rs.recomendar_conocidos(1, 3));
+    EXPECT_TRUE(rs.recomendar_conocidos(1, 0).empty());
+
+    vector<int> excluidos = {6, 7, 99};
+    EXPECT_EQ(Recomendados({{5, 3}, {8, 1}}), rs.recomendar_conocidos(1, 3, excluidos));
+
+    // En una red perezosa da lo mismo, y también desde una instantánea abierta
+    RedSocial perezosa(RedSocial::ModoConocidos::perezoso);
+    string ruta = testing::TempDir() + "red_social_recomendar.instantanea";
+    rs.guardar_instantanea(ruta);
+    perezosa.abrir_instantanea(ruta);
+    EXPECT_EQ(rs.recomendar_conocidos(1, 3), perezosa.recomendar_conocidos(1, 3));
+    perezosa.desamigar_usuarios(5, 4);
+    EXPECT_EQ(Recomendados({{5, 2}, {6, 2}}), perezosa.recomendar_conocidos(1, 2));
+}
+
+TEST(RedSocial, consultas_por_alias_sin_reservar_memoria) {
+    RedSocial rs;
+    for (int i = 0; i < 1000; i++) {
+        rs.registrar_usuario("usuario_con_un_alias_largo_" + to_string(i), i);
+    }
+    string_view alias = rs.obtener_alias(500);
+    const char * buscado = "usuario_con_un_alias_largo_123";
+
+    long long antes = reservas;
+    long long suma = 0;
+    for (int i = 0; i < 1000; i++) {
+        suma += rs.obtener_id(rs.obtener_alias(i));
+    }
+    suma += rs.obtener_id(buscado);
+    EXPECT_EQ(antes, reservas.load());
+    EXPECT_EQ(999 * 1000 / 2 + 123, suma);
+
+    // El alias no se mueve aunque se registren y eliminen otros usuarios; lo liberado se reusa
+    for (int i = 0; i < 1000; i += 2) {
+        rs.eliminar_usuario(i == 500 ? 501 : i);
+    }
+    for (int i = 1000; i < 3000; i++) {
+        rs.registrar_usuario("usuario_con_un_alias_largo_" + to_string(i), i);
+    }
+    EXPECT_EQ("usuario_con_un_alias_largo_500", alias);
+    EXPECT_EQ(alias.data(), rs.obtener_alias(500).data());
+    EXPECT_EQ(2500, rs.obtener_id("usuario_con_un_alias_largo_2500"));
+    EXPECT_THROW(rs.obtener_id("usuario_con_un_alias_largo_0"), out_of_range);
+}
+
+// Recurso que lleva la cuenta de los bytes pedidos y devueltos, y le pasa los pedidos a otro
+class RecursoContado : public pmr::memory_resource {
+  public:
+    explicit RecursoContado(pmr::memory_resource * siguiente) : siguiente(siguiente) {}
+    atomic<long long> pedidos{0};
+    atomic<long long> en_uso{0};
+
+  private:
+    void * do_allocate(size_t bytes, size_t alineacion) override {
+        pedidos++;
+        en_uso += bytes;
+        return siguiente->allocate(bytes, alineacion);
+    }
+    void do_deallocate(void * p, size_t bytes, size_t alineacion) override {
+        en_uso -= bytes;
+        siguiente->deallocate(p, bytes, alineacion);
+    }
+    bool do_is_equal(const pmr::memory_resource & otro) const noexcept override {
+        return this == &otro;
+    }
+    pmr::memory_resource * siguiente;
+};
+
+TEST(RedSocial, recurso_de_memoria) {
+    pmr::synchronized_pool_resource pool;
+    RecursoContado contado(&pool);
+    vector<pair<string, int>> usuarios;
+    vector<pair<int, int>> amistades;
+    for (int i = 0; i < 200; i++) usuarios.push_back({"u" + to_string(i), i});
+    for (int i = 0; i < 200; i++) {
+        amistades.push_back({i, (i + 1) % 200});
+        amistades.push_back({i, (i * 7 + 3) % 200});
+    }
+    {
+        RedSocial comun;
+        RedSocial con_pool(RedSocial::ModoConocidos::ansioso, &contado);
+        comun.cargar_en_bloque(usuarios, {});
+        con_pool.cargar_en_bloque(usuarios, {});
+        long long antes = contado.pedidos;
+        for (auto [a, b] : amistades) {
+            if (a == b || comun.obtener_amigos(a).count("u" + to_string(b))) continue;
+            comun.amigar_usuarios(a, b);
+            con_pool.amigar_usuarios(a, b);
+        }
+        EXPECT_GT(contado.pedidos, antes); // amigos y conocidos salen del recurso
+        con_pool.eliminar_usuario(7);
+        comun.eliminar_usuario(7);
+        for (int id : comun.usuarios()) {
+            EXPECT_EQ(comun.obtener_amigos(id), con_pool.obtener_amigos(id));
+            EXPECT_EQ(comun.obtener_conocidos(id), con_pool.obtener_conocidos(id));
+        }
+        EXPECT_EQ(comun.conocidos_del_usuario_mas_popular(), con_pool.conocidos_del_usuario_mas_popular());
+    }
+    EXPECT_EQ(0, contado.en_uso.load()); // la red devolvió todo al destruirse
+
+    // Con una arena monótona, sin carga en bloque
+    pmr::monotonic_buffer_resource arena;
+    RedSocial rs(RedSocial::ModoConocidos::perezoso, &arena);
+    rs.registrar_usuario("pepe", 1);
+    rs.registrar_usuario("gerva", 2);
+    rs.registrar_usuario("tom", 3);
+    rs.amigar_usuarios(1, 2);
+    rs.amigar_usuarios(2, 3);
+    EXPECT_EQ(set<string>({"tom"}), rs.obtener_conocidos(1));
+}
+
+TEST(RedSocial, mapa_de_bits_coincide_con_set) {
+    mt19937 rng(7);
+    MapaDeBits a, b;
+    set<int> sa, sb;
+    // Un grupo denso, que pasa a bits y vuelve a arreglo, y valores dispersos en otros grupos
+    for (int paso = 0; paso < 40000; paso++) {
+        int x = paso < 20000 ? rng() % 9000 : rng() % 300000;
+        bool insertar = paso < 15000 || rng() % 3 != 0;
+        MapaDeBits & m = paso % 2 ? a : b;
+        set<int> & s = paso % 2 ? sa : sb;
+        if (insertar) EXPECT_EQ(s.insert(x).second, m.insertar(x));
+        else EXPECT_EQ(s.erase(x) == 1, m.borrar(x));
+        if (paso == 30000) {
+            for (int y = 0; y < 9000; y++) {   // vaciar casi todo el grupo denso de a
+                sa.erase(y);
+                a.borrar(y);
+            }
+        }
+    }
+    EXPECT_EQ((int)sa.size(), a.cantidad());
+    EXPECT_EQ((int)sb.size(), b.cantidad());
+    for (int x = 0; x < 300000; x += 7) {
+        EXPECT_EQ(sa.count(x) == 1, a.contiene(x));
+    }
+    vector<int> comunes;
+    set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), back_inserter(comunes));
+    EXPECT_EQ((int)comunes.size(), a.contar_interseccion(b));
+    EXPECT_EQ((int)comunes.size(), b.contar_interseccion(a));
+}
+
+TEST(RedSocial, amigos_de_un_hub) {
+    // 0 es amigo de todos; los pares son además amigos de 1, que también es un hub
+    const int n = 2100;
+    RedSocial rs(RedSocial::ModoConocidos::perezoso);
+    for (int i = 0; i < n; i++) rs.registrar_usuario("u" + to_string(i), i);
+    for (int i = 1; i < n; i++) rs.amigar_usuarios(0, i);
+    for (int i = 2; i < n; i += 2) rs.amigar_usuarios(1, i);
+    rs.amigar_usuarios(3, 5);
+
+    EXPECT_EQ(n / 2 - 1, rs.cantidad_amigos_en_comun(0, 1));   // hub con hub
+    EXPECT_EQ(n / 2 - 1, rs.cantidad_amigos_en_comun(1, 0));
+    EXPECT_EQ(1, rs.cantidad_amigos_en_comun(3, 5));             // sólo 0
+    EXPECT_EQ(vector<int>({0}), rs.amigos_en_comun(3, 5));
+    EXPECT_EQ(vector<int>({0, 1}), rs.amigos_en_comun(2, 4));    // un hub es el amigo en común
+    EXPECT_EQ(vector<int>({5}), rs.amigos_en_comun(3, 0));      // un hub con un usuario común
+    EXPECT_EQ(n - 3, (int)rs.obtener_conocidos(5).size());     // todos salvo 0, 3 y él mismo
+
+    // Al bajar de la mitad del umbral deja de ser hub, y todo sigue igual
+    for (int i = 2; i < n; i += 2) rs.desamigar_usuarios(1, i);
+    rs.amigar_usuarios(1, 3);
+    EXPECT_EQ(vector<int>({0}), rs.amigos_en_comun(1, 3));
+    EXPECT_EQ(1, rs.cantidad_amigos_en_comun(1, 2));
+    rs.eliminar_usuario(0);
+    EXPECT_EQ(0, rs.cantidad_amigos_en_comun(3, 5));
+    EXPECT_EQ(set<string>({"u1"}), rs.obtener_conocidos(5));
+}
+
+template <class Rango>
+static vector<int> a_vector(Rango && rango) {
+    vector<int> ids;
+    for (int id : rango) ids.push_back(id);
+    return ids;
+}
+
+TEST(RedSocial, recorrer_amigos_y_conocidos_de_a_paginas) {
+    static_assert(ranges::view<RedSocial::RangoDeConocidos>);
+    static_assert(ranges::input_range<RedSocial::RangoDeConocidos>);
+    static_assert(ranges::random_access_range<RedSocial::RangoDeAmigos>);
+
+    RedSocial rs(RedSocial::ModoConocidos::perezoso);
+    for (int i = 0; i < 10; i++) rs.registrar_usuario("u" + to_string(i), i);
+    // 0 - {1, 2, 3}; 1 - {4, 5}; 2 - {5, 6}; 3 - {7}
+    for (int f : {1, 2, 3}) rs.amigar_usuarios(0, f);
+    rs.amigar_usuarios(1, 4);
+    rs.amigar_usuarios(1, 5);
+    rs.amigar_usuarios(2, 5);
+    rs.amigar_usuarios(2, 6);
+    rs.amigar_usuarios(3, 7);
+
+    // Los conocidos de 0 salen una sola vez cada uno, agrupados por el primer amigo en común
+    EXPECT_EQ(vector<int>({4, 5, 6, 7}), a_vector(rs.conocidos_desde(0)));
+    EXPECT_EQ(vector<int>({5, 6}), a_vector(rs.conocidos_desde(0) | views::drop(1) | views::take(2)));
+
+    RedSocial::Pagina pagina = rs.pagina_de_conocidos(0, 3);
+    EXPECT_EQ(vector<int>({4, 5, 6}), pagina.ids);
+    EXPECT_TRUE(pagina.hay_mas);
+    // La ficha sigue sirviendo aunque la red cambie: 8 es un conocido nuevo antes del 7
+    rs.amigar_usuarios(3, 8);
+    pagina = rs.pagina_de_conocidos(0, 3, pagina.siguiente);
+    EXPECT_EQ(vector<int>({7, 8}), pagina.ids);
+    EXPECT_FALSE(pagina.hay_mas);
+
+    EXPECT_EQ(vector<int>({2, 3}), a_vector(rs.amigos_desde(0) | views::drop(1)));
+    pagina = rs.pagina_de_amigos(0, 2);
+    EXPECT_EQ(vector<int>({1, 2}), pagina.ids);
+    EXPECT_TRUE(pagina.hay_mas);
+    pagina = rs.pagina_de_amigos(0, 2, pagina.siguiente);
+    EXPECT_EQ(vector<int>({3}), pagina.ids);
+    EXPECT_FALSE(pagina.hay_mas);
+    EXPECT_TRUE(rs.pagina_de_conocidos(9, 5).ids.empty());
+}
+
+TEST(RedSocial, reporte_de_instrumentacion) {
+    RedSocial rs;
+    rs.registrar_usuario("pepe", 1);
+    rs.registrar_usuario("gerva", 2);
+    rs.registrar_usuario("tom", 3);
+    rs.amigar_usuarios(1, 2);
+    rs.amigar_usuarios(2, 3);
+    rs.obtener_conocidos(1);
+
+    string texto = rs.reporte();
+    EXPECT_NE(string::npos, texto.find("usuarios 3\n"));
+    EXPECT_NE(string::npos, texto.find("amistades 2\n"));
+    EXPECT_NE(string::npos, texto.find("conocidos_guardados 2\n"));
+    string json = rs.reporte(FormatoReporte::json);
+    EXPECT_NE(string::npos, json.find("\"tamanios\": {\"usuarios\": 3, \"amistades\": 2"));
+    EXPECT_EQ('}', json.back());
+
+#ifdef REDSOCIAL_INSTRUMENTACION
+    const Instrumentacion & medidas = rs.instrumentacion();
+    EXPECT_EQ(2u, medidas.histograma(Operacion::amigar_usuarios).cantidad());
+    EXPECT_EQ(3u, medidas.histograma(Operacion::registrar_usuario).cantidad());
+    EXPECT_EQ(1u, medidas.histograma(Operacion::obtener_conocidos).cantidad());
+    EXPECT_EQ(0u, medidas.histograma(Operacion::eliminar_usuario).cantidad());
+    EXPECT_EQ(1u, medidas.contador(Contador::vistas_materializadas));
+    EXPECT_LE(medidas.histograma(Operacion::amigar_usuarios).percentil(50),
+              medidas.histograma(Operacion::amigar_usuarios).maximo());
+    EXPECT_NE(string::npos, json.find("\"amigar_usuarios\": {\"llamadas\": 2"));
+    rs.reiniciar_instrumentacion();
+    EXPECT_EQ(0u, rs.instrumentacion().histograma(Operacion::amigar_usuarios).cantidad());
+#endif
+}
+
+TEST(RedSocial, histograma_de_latencias) {
+    Histograma h;
+    for (uint64_t v = 1; v <= 100000; v++) h.registrar(v);
+    EXPECT_EQ(100000u, h.cantidad());
+    EXPECT_EQ(100000u, h.maximo());
+    EXPECT_EQ(100000ull * 100001 / 2, h.suma());
+    // Error relativo menor a 1/32 en cada percentil
+    for (double p : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+        double exacto = p / 100 * 100000;
+        EXPECT_NEAR(exacto, (double)h.percentil(p), exacto / 32) << p;
+    }
+    EXPECT_EQ(100000u, h.percentil(100));
+    h.reiniciar();
+    EXPECT_EQ(0u, h.percentil(50));
+}
+
+TEST(RedSocial, reconstruir_todo_en_paralelo) {
+    // Una red armada de a un cambio, con algunos usuarios perezosos
+    const int n = 300;
+    RedSocial rs;
+    for (int i = 0; i < n; i++) rs.registrar_usuario("u" + to_string(i), i);
+    auto amigar = [&](int a, int b) {
+        if (a != b && b < n && !rs.obtener_amigos(a).count("u" + to_string(b))) rs.amigar_usuarios(a, b);
+    };
+    for (int i = 0; i < n; i++) {
+        for (int j : {i + 1, i + 7, (i * 31) % n}) amigar(i, j);
+    }
+    for (int i = 1; i < n; i += 3) amigar(0, i); // uno mucho más caro que el resto
+    for (int i = 0; i < n; i += 5) rs.fijar_modo_conocidos(i, RedSocial::ModoConocidos::perezoso);
+    rs.eliminar_usuario(150);
+
+    map<int, set<string>> amigos, conocidos;
+    for (int id : rs.usuarios()) {
+        amigos[id] = rs.obtener_amigos(id);
+        conocidos[id] = rs.obtener_conocidos(id);
+    }
+    const int amistades = rs.cantidad_amistades();
+    const vector<int> populares = rs.mas_populares(20);
+
+    auto igual_que_antes = [&](const RedSocial & red) {
+        EXPECT_EQ(amistades, red.cantidad_amistades());
+        EXPECT_EQ(populares, red.mas_populares(20));
+        for (int id : red.usuarios()) {
+            EXPECT_EQ(amigos[id], red.obtener_amigos(id)) << id;
+            EXPECT_EQ(conocidos[id], red.obtener_conocidos(id)) << id;
+        }
+        EXPECT_EQ(conocidos[populares[0]], red.conocidos_del_usuario_mas_popular());
+    };
+
+    // Con más hilos que núcleos, para que haya robos aunque la máquina tenga uno solo
+    for (int hilos : {1, 4, 0}) {
+        rs.reconstruir_todo(hilos);
+        igual_que_antes(rs);
+    }
+
+    // También desde una instantánea abierta, que todavía no se copió a memoria propia
+    string ruta = testing::TempDir() + "red_social_reconstruir.snap";
+    rs.guardar_instantanea(ruta, false);
+    RedSocial abierta;
+    abierta.abrir_instantanea(ruta);
+    abierta.reconstruir_todo(3);
+    igual_que_antes(abierta);
+
+    // Y los cambios posteriores siguen manteniendo todo al día
+    rs.desamigar_usuarios(0, 1);
+    abierta.desamigar_usuarios(0, 1);
+    for (int id : rs.usuarios()) {
+        EXPECT_EQ(rs.obtener_conocidos(id), abierta.obtener_conocidos(id)) << id;
+    }
+    EXPECT_EQ(rs.mas_populares(5), abierta.mas_populares(5));
+    remove(ruta.c_str());
+}
+
+TEST(RedSocial, transaccion_de_amistades) {
+    vector<pair<string, int>> usuarios = {
+        {"pablo", 7}, {"pepe", 6}, {"agus", 5}, {"gerva", 4},
+        {"tom", 3}, {"vir", 2}, {"vivi", 1}, {"pedro", 0}};
+    RedSocial de_a_uno, en_tanda;
+    for (auto [alias, id] : usuarios) {
+        de_a_uno.registrar_usuario(alias, id);
+        en_tanda.registrar_usuario(alias, id);
+    }
+    for (auto [a, b] : {pair(1, 2), pair(1, 3), pair(4, 5)}) {
+        de_a_uno.amigar_usuarios(a, b);
+        en_tanda.amigar_usuarios(a, b);
+    }
+    en_tanda.publicar();
+    auto antes = en_tanda.version();
+
+    RedSocial::Transaccion t = en_tanda.transaccion();
+    t.amigar_usuarios(1, 0);
+    t.amigar_usuarios(6, 5);
+    t.desamigar_usuarios(5, 6);                // se cancela con el anterior
+    t.amigar_usuarios(5, 6);                   // y vuelve a quedar
+    t.desamigar_usuarios(1, 3);
+    t.amigar_usuarios(3, 1);                   // ya eran amigos: no cambia nada
+    t.desamigar_usuarios(4, 5);
+    t.amigar_usuarios(2, 2);                   // consigo mismo: se ignora
+    t.amigar_usuarios(0, 7);
+    EXPECT_EQ(5, t.pendientes());
+
+    // Nada cambia hasta confirmar
+    EXPECT_EQ(3, en_tanda.cantidad_amistades());
+    EXPECT_EQ(set<string>(), en_tanda.obtener_amigos(0));
+
+    t.confirmar();
+    EXPECT_EQ(0, t.pendientes());
+    de_a_uno.amigar_usuarios(1, 0);
+    de_a_uno.amigar_usuarios(6, 5);
+    de_a_uno.desamigar_usuarios(4, 5);
+    de_a_uno.amigar_usuarios(0, 7);
+
+    EXPECT_EQ(de_a_uno.cantidad_amistades(), en_tanda.cantidad_amistades());
+    EXPECT_EQ(de_a_uno.mas_populares(8), en_tanda.mas_populares(8));
+    EXPECT_EQ(de_a_uno.conocidos_del_usuario_mas_popular(), en_tanda.conocidos_del_usuario_mas_popular());
+    for (int id : de_a_uno.usuarios()) {
+        EXPECT_EQ(de_a_uno.obtener_amigos(id), en_tanda.obtener_amigos(id)) << id;
+        EXPECT_EQ(de_a_uno.obtener_conocidos(id), en_tanda.obtener_conocidos(id)) << id;
+    }
+
+    // Los lectores siguen viendo la versión anterior entera hasta que se publique
+    EXPECT_EQ(3, antes->cantidad_amistades());
+    EXPECT_EQ(set<string>({"agus"}), antes->obtener_amigos(4));
+    en_tanda.publicar();
+    EXPECT_EQ(5, en_tanda.version()->cantidad_amistades());
+    EXPECT_EQ(set<string>(), en_tanda.version()->obtener_amigos(4));
+
+    // Con un id desconocido no se aplica nada, y los cambios quedan para reintentar
+    t.desamigar_usuarios(1, 0);
+    t.amigar_usuarios(1, 99);
+    EXPECT_THROW(t.confirmar(), out_of_range);
+    EXPECT_EQ(2, t.pendientes());
+    EXPECT_EQ(set<string>({"pedro", "vir", "tom"}), en_tanda.obtener_amigos(1));
+    t.descartar();
+    t.confirmar();
+    EXPECT_EQ(5, en_tanda.cantidad_amistades());
+}
+
+TEST(RedSocial, distancia_y_vecindario) {
+    // Un camino 0 - 1 - ... - 9, una componente aparte {20, 21} y un usuario aislado
+    RedSocial rs;
+    for (int i : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 20, 21, 30}) rs.registrar_usuario("u" + to_string(i), i);
+    for (int i = 0; i < 9; i++) rs.amigar_usuarios(i, i + 1);
+    rs.amigar_usuarios(20, 21);
+
+    EXPECT_EQ(0, rs.distancia(4, 4));
+    EXPECT_EQ(1, rs.distancia(4, 5));
+    EXPECT_EQ(9, rs.distancia(0, 9));
+    EXPECT_EQ(9, rs.distancia(9, 0));
+    EXPECT_EQ(-1, rs.distancia(0, 20));
+    EXPECT_EQ(-1, rs.distancia(30, 21));
+    EXPECT_THROW(rs.distancia(0, 99), out_of_range);
+
+    EXPECT_EQ(vector<int>({2, 3, 5, 6}), rs.vecindario(4, 2));
+    EXPECT_EQ(vector<int>({1, 2, 3, 4, 5, 6, 7, 8, 9}), rs.vecindario(0, 100));
+    EXPECT_EQ(vector<int>({21}), rs.vecindario(20, 3));
+    EXPECT_EQ(vector<int>(), rs.vecindario(30, 3));
+    EXPECT_EQ(vector<int>(), rs.vecindario(4, 0));
+
+    // Un atajo acorta los caminos
+    rs.amigar_usuarios(0, 9);
+    EXPECT_EQ(1, rs.distancia(0, 9));
+    EXPECT_EQ(4, rs.distancia(1, 7));
+    EXPECT_EQ(vector<int>({1, 2, 3, 7, 8, 9}), rs.vecindario(0, 3));
+}
+
+TEST(RedSocial, vecindario_coincide_con_bfs) {
+    // Una red con un hub, así la frontera crece rápido y se recorre de abajo hacia arriba
+    const int n = 3000;
+    RedSocial rs;
+    vector<vector<int>> amigos(n);
+    for (int i = 0; i < n; i++) rs.registrar_usuario("u" + to_string(i), i);
+    auto amigar = [&](int a, int b) {
+        if (a == b || find(amigos[a].begin(), amigos[a].end(), b) != amigos[a].end()) return;
+        rs.amigar_usuarios(a, b);
+        amigos[a].push_back(b);
+        amigos[b].push_back(a);
+    };
+    for (int i = 0; i + 1 < n - 100; i++) amigar(i, (i * 7919 + 13) % (n - 100)); // los últimos 100 aparte
+    for (int i = 0; i < n - 100; i += 3) amigar(1, i);
+    for (int i = n - 100; i + 1 < n; i++) amigar(i, i + 1);
+
+    auto bfs = [&](int origen) {
+        vector<int> distancia(n, -1);
+        vector<int> cola = {origen};
+        distancia[origen] = 0;
+        for (size_t i = 0; i < cola.size(); i++) {
+            for (int w : amigos[cola[i]]) {
+                if (distancia[w] == -1) {
+                    distancia[w] = distancia[cola[i]] + 1;
+                    cola.push_back(w);
+                }
+            }
+        }
+        return distancia;
+    };
+    for (int origen : {0, 2, 500, n - 50}) {
+        vector<int> distancia = bfs(origen);
+        for (int k : {1, 2, 3, 5}) {
+            vector<int> esperado;
+            for (int v = 0; v < n; v++) {
+                if (v != origen && distancia[v] != -1 && distancia[v] <= k) esperado.push_back(v);
+            }
+            EXPECT_EQ(esperado, rs.vecindario(origen, k)) << origen << " " << k;
+            EXPECT_EQ(esperado, rs.vecindario(origen, k, 4)) << origen << " " << k;
+        }
+        for (int destino : {1, 3, 1234, n - 1, n - 100}) {
+            EXPECT_EQ(distancia[destino], rs.distancia(origen, destino)) << origen << " " << destino;
+        }
+    }
+}
+
+TEST(RedSocial, triangulos_y_coeficiente_de_agrupamiento) {
+    // Dos triángulos que comparten la amistad 1 - 2, y 4 colgado de 3
+    RedSocial rs;
+    for (int i = 0; i < 5; i++) rs.registrar_usuario("u" + to_string(i), i);
+    for (auto [a, b] : {pair(0, 1), pair(0, 2), pair(1, 2), pair(1, 3), pair(2, 3), pair(3, 4)}) {
+        rs.amigar_usuarios(a, b);
+    }
+    EXPECT_EQ(2, rs.cantidad_triangulos());
+    EXPECT_EQ(1, rs.triangulos(0));
+    EXPECT_EQ(2, rs.triangulos(1));
+    EXPECT_EQ(1, rs.triangulos(3));
+    EXPECT_EQ(0, rs.triangulos(4));
+    EXPECT_DOUBLE_EQ(1.0, rs.coeficiente_de_agrupamiento(0));
+    EXPECT_DOUBLE_EQ(2.0 / 3, rs.coeficiente_de_agrupamiento(1));
+    EXPECT_DOUBLE_EQ(1.0 / 3, rs.coeficiente_de_agrupamiento(3));
+    EXPECT_DOUBLE_EQ(0.0, rs.coeficiente_de_agrupamiento(4));
+    // Caminos de largo 2: 1 + 3 + 3 + 3 + 0 = 10
+    EXPECT_DOUBLE_EQ(3.0 * 2 / 10, rs.coeficiente_de_agrupamiento_global());
+
+    // De a un cambio, en una transacción y al eliminar
+    rs.amigar_usuarios(2, 4);
+    EXPECT_EQ(3, rs.cantidad_triangulos());
+    EXPECT_EQ(3, rs.triangulos(2));
+    rs.desamigar_usuarios(1, 2);
+    EXPECT_EQ(1, rs.cantidad_triangulos());
+    EXPECT_EQ(0, rs.triangulos(0));
+    RedSocial::Transaccion t = rs.transaccion();
+    t.amigar_usuarios(1, 2);
+    t.amigar_usuarios(0, 3);
+    t.confirmar();                             // 1 - 2 cierra dos triángulos y 0 - 3 otros dos
+    EXPECT_EQ(5, rs.cantidad_triangulos());
+    EXPECT_EQ(3, rs.triangulos(0));
+    EXPECT_EQ(4, rs.triangulos(2));
+    rs.eliminar_usuario(3);
+    EXPECT_EQ(1, rs.cantidad_triangulos());
+    EXPECT_EQ(1, rs.triangulos(2));
+    EXPECT_EQ(0, rs.triangulos(4));
+
+    // Lo que se mantuvo coincide con contarlos de nuevo, también desde una instantánea
+    vector<long long> antes;
+    for (int id : rs.usuarios()) antes.push_back(rs.triangulos(id));
+    rs.reconstruir_todo(2);
+    string ruta = testing::TempDir() + "red_social_triangulos.snap";
+    rs.guardar_instantanea(ruta);
+    RedSocial abierta;
+    abierta.abrir_instantanea(ruta);
+    for (const RedSocial * red : {&rs, &abierta}) {
+        vector<long long> despues;
+        for (int id : red->usuarios()) despues.push_back(red->triangulos(id));
+        EXPECT_EQ(antes, despues);
+        EXPECT_EQ(1, red->cantidad_triangulos());
+    }
+    remove(ruta.c_str());
+}
+
+TEST(RedSocial, componentes_conexas) {
+    // Una estrella con centro 0 y brazos 1 - 2, 3 - 4 y 5, y aparte 6 - 7 y 8 solo
+    RedSocial rs;
+    for (int i = 0; i < 9; i++) rs.registrar_usuario("u" + to_string(i), i);
+    EXPECT_EQ(9, rs.cantidad_componentes());
+    for (auto [a, b] : {pair(0, 1), pair(1, 2), pair(0, 3), pair(3, 4), pair(0, 5), pair(6, 7)}) {
+        rs.amigar_usuarios(a, b);
+    }
+    EXPECT_EQ(3, rs.cantidad_componentes());
+    EXPECT_TRUE(rs.misma_componente(2, 4));
+    EXPECT_FALSE(rs.misma_componente(2, 7));
+    EXPECT_EQ(6, rs.tamanio_de_componente(5));
+    EXPECT_EQ(2, rs.tamanio_de_componente(6));
+    EXPECT_EQ(1, rs.tamanio_de_componente(8));
+
+    // Un ciclo no se parte al cortarlo; un puente sí
+    rs.amigar_usuarios(2, 4);
+    rs.desamigar_usuarios(0, 1);
+    EXPECT_EQ(3, rs.cantidad_componentes());
+    rs.desamigar_usuarios(3, 4);
+    EXPECT_EQ(4, rs.cantidad_componentes());
+    EXPECT_EQ(vector<int>({3, 3}), vector<int>({rs.tamanio_de_componente(1), rs.tamanio_de_componente(0)}));
+    EXPECT_FALSE(rs.misma_componente(1, 0));
+
+    // Eliminar el centro deja un pedazo por amigo
+    rs.amigar_usuarios(0, 7);
+    rs.eliminar_usuario(0);
+    EXPECT_EQ(5, rs.cantidad_componentes());
+    EXPECT_FALSE(rs.misma_componente(3, 5));
+    EXPECT_TRUE(rs.misma_componente(6, 7));
+    EXPECT_EQ(1, rs.tamanio_de_componente(3));
+
+    // Una transacción que une y corta a la vez
+    RedSocial::Transaccion t = rs.transaccion();
+    t.amigar_usuarios(3, 5);
+    t.amigar_usuarios(5, 8);
+    t.desamigar_usuarios(6, 7);
+    t.desamigar_usuarios(1, 2);
+    t.confirmar();
+    EXPECT_EQ(5, rs.cantidad_componentes()); // {1}, {2, 4}, {3, 5, 8}, {6}, {7}
+    EXPECT_EQ(3, rs.tamanio_de_componente(8));
+    EXPECT_FALSE(rs.misma_componente(6, 7));
+
+    // Contarlas de nuevo da lo mismo, también desde una instantánea
+    rs.reconstruir_todo(2);
+    string ruta = testing::TempDir() + "red_social_componentes.snap";
+    rs.guardar_instantanea(ruta);
+    RedSocial abierta;
+    abierta.abrir_instantanea(ruta);
+    for (const RedSocial * red : {&rs, &abierta}) {
+        EXPECT_EQ(5, red->cantidad_componentes());
+        EXPECT_TRUE(red->misma_componente(2, 4));
+        EXPECT_TRUE(red->misma_componente(3, 8));
+        EXPECT_FALSE(red->misma_componente(1, 2));
+        EXPECT_EQ(1, red->tamanio_de_componente(7));
+    }
+    remove(ruta.c_str());
+}
+
+TEST(RedSocial, uso_de_memoria) {
+    RedSocial rs;
+    auto bytes_de = [&](const string & estructura) {
+        for (const auto& [nombre, bytes] : rs.uso_de_memoria().por_estructura) {
+            if (nombre == estructura) return bytes;
+        }
+        ADD_FAILURE() << "falta " << estructura;
+        return size_t(0);
+    };
+    EXPECT_EQ(0.0, rs.uso_de_memoria().bytes_por_usuario);
+
+    for (int i = 0; i < 1000; i++) {
+        rs.registrar_usuario("usuario_" + to_string(i), i);
+    }
+    for (int i = 1; i < 1000; i++) {
+        rs.amigar_usuarios(0, i);
+    }
+    RedSocial::UsoDeMemoria uso = rs.uso_de_memoria();
+    size_t suma = 0;
+    for (const auto& [nombre, bytes] : uso.por_estructura) suma += bytes;
+    EXPECT_EQ(suma, uso.total);
+    EXPECT_DOUBLE_EQ(uso.total / 1000.0, uso.bytes_por_usuario);
+    EXPECT_DOUBLE_EQ(uso.total / 999.0, uso.bytes_por_amistad);
+
+    // Cada alias ocupa sus caracteres más un byte de largo en la arena, y 4 bytes en el slot
+    EXPECT_GE(bytes_de("alias"), 1000 * (string("usuario_999").size() + 1 + 4));
+    EXPECT_GE(bytes_de("amigos"), 2 * 999 * sizeof(int));
+    EXPECT_GE(bytes_de("conocidos"), 999 * 998 * 2 * sizeof(int)); // cada par de hojas se conoce
+
+    // Materializar una vista suma sus alias; eliminar al centro libera los nodos de los
+    // conocidos, aunque las tablas se quedan con sus cubetas
+    size_t vistas = bytes_de("vistas"), conocidos = bytes_de("conocidos");
+    rs.obtener_amigos(0);
+    EXPECT_GT(bytes_de("vistas"), vistas + 999 * string("usuario_1").size());
+    rs.eliminar_usuario(0);
+    EXPECT_EQ(0.0, rs.uso_de_memoria().bytes_por_amistad);
+    EXPECT_LT(bytes_de("conocidos"), conocidos);
+
+    string texto = rs.reporte();
+    EXPECT_NE(string::npos, texto.find("bytes_alias "));
+    EXPECT_NE(string::npos, texto.find("bytes_por_usuario "));
+
+    // Los alias largos llevan el largo en 3 bytes; los que no entran en un bloque no se registran
+    string largo(300, 'x');
+    rs.registrar_usuario(largo, 5000);
+    EXPECT_EQ(largo, rs.obtener_alias(5000));
+    EXPECT_EQ(5000, rs.obtener_id(largo));
+    EXPECT_THROW(rs.registrar_usuario(string(1 << 16, 'y'), 5001), length_error);
+    EXPECT_FALSE(rs.usuarios().count(5001));
+    EXPECT_EQ(1000u, rs.usuarios().size());
+}